@@ -352,10 +352,18 @@ SOURCE=..\..\src\video\SDL_pixels.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_present.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\video\SDL_pixels_c.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_present_c.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\stdlib\SDL_qsort.c
 # End Source File
 # Begin Source File
@@ -364,10 +372,22 @@ SOURCE=..\..\src\events\SDL_quit.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\events\SDL_record.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\events\SDL_resize.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\video\SDL_region.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\video\SDL_region_c.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\video\SDL_RLEaccel.c
 # End Source File
 # Begin Source File
@@ -57,6 +57,27 @@ extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE(void);
 /** This function returns true if the CPU has SSE2 features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE2(void);
 
+/** This function returns true if the CPU has SSE3 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE3(void);
+
+/** This function returns true if the CPU has SSSE3 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSSE3(void);
+
+/** This function returns true if the CPU has SSE4.1 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE41(void);
+
+/** This function returns true if the CPU has SSE4.2 features */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasSSE42(void);
+
+/** This function returns true if the CPU and OS support AVX */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX(void);
+
+/** This function returns true if the CPU and OS support AVX2 */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX2(void);
+
+/** This function returns true if the CPU and OS support AVX-512 Foundation */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX512F(void);
+
 /** This function returns true if the CPU has AltiVec features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasAltiVec(void);
 
@@ -66,6 +87,38 @@ extern DECLSPEC SDL_bool SDLCALL SDL_HasARMSIMD(void);
 /** This function returns true if the CPU has ARM NEON features */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasARMNEON(void);
 
+/** A guess at the CPU cache line size, for when it can't be found out */
+#define SDL_CACHELINE_SIZE	128
+
+/** This function returns the L1 cache line size of the CPU in bytes */
+extern DECLSPEC int SDLCALL SDL_GetCPUCacheLineSize(void);
+
+/**
+ * This function returns the size in bytes of the level 1, 2 or 3 data
+ * cache of the first CPU, or 0 if there isn't one or it can't be found out.
+ * A shared cache is reported at its full size.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCacheSize(int level);
+
+/** This function returns the number of logical CPUs available */
+extern DECLSPEC int SDLCALL SDL_GetCPUCount(void);
+
+/**
+ * This function returns the number of physical CPU cores, not counting
+ * hyperthreads, or the number of logical CPUs if it can't be found out.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCoreCount(void);
+
+/**
+ * The features reported by these functions can be turned off with the
+ * SDL_CPU_MASK environment variable, to compare or pin the code paths SDL
+ * uses.  It is a comma separated list of the names mmx, mmxext, 3dnow,
+ * 3dnowext, sse, sse2, sse3, ssse3, sse41, sse42, avx, avx2, avx512f,
+ * altivec, armsimd and neon.  "-name" turns that feature off, a plain x86
+ * SIMD name like "sse2" turns off every later x86 SIMD level, and "none"
+ * turns off everything.  It is read the first time a feature is checked.
+ */
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
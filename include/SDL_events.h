@@ -35,6 +35,7 @@
 #include "SDL_mouse.h"
 #include "SDL_joystick.h"
 #include "SDL_quit.h"
+#include "SDL_rwops.h"
 
 #include "begin_code.h"
 /* Set up for C function definitions, even when using C++ */
@@ -277,6 +278,40 @@ typedef enum {
 extern DECLSPEC int SDLCALL SDL_PeepEvents(SDL_Event *events, int numevents,
 				SDL_eventaction action, Uint32 mask);
 
+#ifdef SDL_HAS_64BIT_TYPE
+/**
+ *  Works like SDL_PeepEvents(), and also stores in 'times' the value of
+ *  SDL_GetPerformanceCounter() when each event returned was added to the
+ *  queue.  With SDL_ADDEVENT, 'times' gives the times to record for the
+ *  events added instead.  'times' may be NULL.
+ *
+ *  This function is thread-safe.
+ */
+extern DECLSPEC int SDLCALL SDL_PeepEventTimes(SDL_Event *events, Uint64 *times,
+		int numevents, SDL_eventaction action, Uint32 mask);
+
+/**
+ *  Returns the value of SDL_GetPerformanceCounter() when the event most
+ *  recently removed from the queue, for instance by SDL_PollEvent(), was
+ *  added to it, or 0 if no event has been removed yet.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetEventTime(void);
+#endif /* SDL_HAS_64BIT_TYPE */
+
+/**
+ *  Removes every event matching 'mask' from the event queue at once.
+ *  The first 'numevents' of them are stored in 'events', in queue order,
+ *  and the rest are discarded.  'events' may be NULL to discard them all.
+ *
+ *  @return
+ *  This function returns the number of events removed, which may be more
+ *  than 'numevents', or -1 if there was an error.
+ *
+ *  This function is thread-safe.
+ */
+extern DECLSPEC int SDLCALL SDL_DrainEvents(SDL_Event *events, int numevents,
+				Uint32 mask);
+
 /** Polls for currently pending events, and returns 1 if there are any pending
  *  events, or 0 if there are none available.  If 'event' is not NULL, the next
  *  event is removed from the queue and stored in that area.
@@ -289,12 +324,111 @@ extern DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event *event);
  */
 extern DECLSPEC int SDLCALL SDL_WaitEvent(SDL_Event *event);
 
+/** Waits up to 'timeout' milliseconds for the next available event, returning
+ *  1, or 0 if the timeout expired or there was an error while waiting for
+ *  events.  A negative timeout waits indefinitely, like SDL_WaitEvent().
+ *  If 'event' is not NULL, the next event is removed from the queue and
+ *  stored in that area.
+ *
+ *  Where the video driver supports it, the waiting thread sleeps until an
+ *  event arrives rather than polling for them.
+ */
+extern DECLSPEC int SDLCALL SDL_WaitEventTimeout(SDL_Event *event, int timeout);
+
 /** Add an event to the event queue.
  *  This function returns 0 on success, or -1 if the event queue was full
  *  or there was some other error.
  */
 extern DECLSPEC int SDLCALL SDL_PushEvent(SDL_Event *event);
 
+/** @name Event Queue Size */
+/*@{*/
+/**
+ *  Sets the most events the event queue will hold; events added while it
+ *  is full are dropped.  The queue only allocates memory for the events
+ *  actually in it, and holds 65536 events by default, or the number in the
+ *  SDL_EVENT_QUEUE_SIZE environment variable.  Events already queued are
+ *  kept if the new size is smaller.
+ *  This function returns 0 on success, or -1 if 'maxevents' isn't positive.
+ */
+extern DECLSPEC int SDLCALL SDL_SetEventQueueSize(int maxevents);
+
+/** Counters for the event queue */
+typedef struct SDL_EventQueueStats {
+	Uint32 queued;		/**< Events in the queue now */
+	Uint32 peak;		/**< Most events that have been in the queue */
+	Uint32 capacity;	/**< Most events the queue will hold */
+	Uint32 pushed;		/**< Events added to the queue */
+	Uint32 dropped;		/**< Events dropped because the queue was full */
+	Uint32 merged;		/**< Events merged into the one before them */
+} SDL_EventQueueStats;
+
+/**
+ *  Get the event queue counters since the event loop was started, or since
+ *  they were last reset.  SDL_ResetEventQueueStats() sets the peak to the
+ *  number of events queued now.
+ */
+extern DECLSPEC void SDLCALL SDL_GetEventQueueStats(SDL_EventQueueStats *stats);
+extern DECLSPEC void SDLCALL SDL_ResetEventQueueStats(void);
+/*@}*/
+
+/**
+ *  Turns on merging of the event types in 'mask' into the last event in the
+ *  queue, if it has the same type and hasn't been read yet.  Merging keeps
+ *  fast input devices from filling the queue without losing any input.
+ *
+ *  SDL_MOUSEMOTION events add their relative motion to the queued event and
+ *  replace its position and button state.  SDL_VIDEORESIZE events replace
+ *  its size, and SDL_VIDEOEXPOSE events are dropped.  Other types in 'mask'
+ *  are ignored.  Merging is off by default.
+ *
+ *  This function returns the previous mask.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_SetEventCoalescing(Uint32 mask);
+
+/** @name Event Recording */
+/*@{*/
+/**
+ *  Starts writing the events of the types in 'mask' to 'dst' as they are
+ *  added to the event queue, with the time each one was added, so they can
+ *  be played back later by SDL_ReplayEvents().  Keyboard events keep their
+ *  keysym and unicode value; user events keep only their code, and
+ *  SDL_SYSWMEVENT events are never recorded.  Events the application adds
+ *  itself with SDL_PushEvent() are recorded too, so leave their types out
+ *  of 'mask' if the application will add them again during replay.
+ *
+ *  Passing NULL for 'dst' stops recording.  The application keeps
+ *  ownership of 'dst' and may close it once recording has stopped.
+ *  Recording stops by itself if writing fails or the event loop is shut
+ *  down.
+ *
+ *  This function returns 0 on success, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_RecordEvents(SDL_RWops *dst, Uint32 mask);
+
+/**
+ *  Starts playing back the events recorded in 'src'.  Each time events are
+ *  pumped, the recorded events that are due are sent through the same
+ *  paths as events from the video driver, so the keyboard and mouse state
+ *  follow them.  This works with any video driver, including "dummy", so
+ *  recorded sessions can be replayed without a display.
+ *
+ *  'speed' scales the pace of the recording: 1.0 plays it at the original
+ *  pace and 2.0 twice as fast.  If it is zero or less, the events are
+ *  added as fast as the event queue takes them.  Key repeats are recorded
+ *  but not replayed, since SDL generates them again from the key presses.
+ *
+ *  Passing NULL for 'src' stops playback.  The application keeps ownership
+ *  of 'src' and may close it once SDL_ReplayingEvents() returns 0.
+ *
+ *  This function returns 0 on success, or -1 if 'src' isn't a recording.
+ */
+extern DECLSPEC int SDLCALL SDL_ReplayEvents(SDL_RWops *src, double speed);
+
+/** Returns 1 while SDL_ReplayEvents() has events left to play back */
+extern DECLSPEC int SDLCALL SDL_ReplayingEvents(void);
+/*@}*/
+
 /** @name Event Filtering */
 /*@{*/
 typedef int (SDLCALL *SDL_EventFilter)(const SDL_Event *event);
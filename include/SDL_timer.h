@@ -48,9 +48,34 @@ extern "C" {
  */ 
 extern DECLSPEC Uint32 SDLCALL SDL_GetTicks(void);
 
+#ifdef SDL_HAS_64BIT_TYPE
+/**
+ * Get the number of milliseconds since the SDL library initialization,
+ * as a 64-bit value that doesn't wrap.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetTicks64(void);
+
+/**
+ * Get the current value of the high resolution counter.  The counter only
+ * goes forward, and is meant for measuring short intervals precisely.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceCounter(void);
+
+/** Get the number of counts per second of the high resolution counter */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceFrequency(void);
+#endif /* SDL_HAS_64BIT_TYPE */
+
 /** Wait a specified number of milliseconds before returning */
 extern DECLSPEC void SDLCALL SDL_Delay(Uint32 ms);
 
+/**
+ * Wait a specified number of microseconds before returning.
+ * This sleeps for most of the time and then waits on the high resolution
+ * counter for the rest, so it is much more precise than SDL_Delay(), at
+ * the cost of keeping a CPU busy for up to a few milliseconds.
+ */
+extern DECLSPEC void SDLCALL SDL_DelayPrecise(Uint32 us);
+
 /** Function prototype for the timer callback function */
 typedef Uint32 (SDLCALL *SDL_TimerCallback)(Uint32 interval);
 
@@ -108,12 +133,97 @@ typedef struct _SDL_TimerID *SDL_TimerID;
  */
 extern DECLSPEC SDL_TimerID SDLCALL SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *param);
 
+/**
+ * Function prototype for the precise timer callback function.
+ * The callback function is passed the current timer interval in
+ * microseconds, and the number of times the timer came due since the last
+ * call without the callback running, because it ran late.  It returns the
+ * next timer interval like SDL_NewTimerCallback.
+ */
+typedef Uint32 (SDLCALL *SDL_PreciseTimerCallback)(Uint32 interval, Uint32 overruns, void *param);
+
+/**
+ * Add a new timer with an interval in microseconds to the pool of timers
+ * already running.  Periodic timers are scheduled from their previous
+ * deadline rather than from when their callback ran, so they don't drift,
+ * and deadlines that were missed are skipped and counted as overruns.
+ * Remove the timer with SDL_RemoveTimer().
+ *
+ * On Linux a timer thread of its own sleeps until the exact deadline,
+ * while timers checked by the SDL event thread or on other platforms are
+ * limited by how often they are checked.
+ *
+ * Returns a timer ID, or NULL when an error occurs.
+ */
+extern DECLSPEC SDL_TimerID SDLCALL SDL_AddPreciseTimer(Uint32 interval, SDL_PreciseTimerCallback callback, void *param);
+
 /**
  * Remove one of the multiple timers knowing its ID.
  * Returns a boolean value indicating success.
  */
 extern DECLSPEC SDL_bool SDLCALL SDL_RemoveTimer(SDL_TimerID t);
 
+/** Statistics for one of the multiple timers, with times in microseconds */
+typedef struct SDL_TimerStats {
+	Uint32 calls;		/**< Times the callback has run */
+	Uint32 overruns;	/**< Deadlines skipped because the timer ran late */
+	Uint32 latency_avg;	/**< Time from the deadline to the callback */
+	Uint32 latency_max;
+	Uint32 duration_avg;	/**< Time the callback took */
+	Uint32 duration_max;
+} SDL_TimerStats;
+
+/**
+ * Get the statistics of one of the multiple timers since it was added.
+ * Returns 0, or -1 if the timer isn't running.
+ *
+ * Timer callbacks normally run one after another on a single thread.  If
+ * the SDL_TIMER_THREADS environment variable is set when the timer
+ * subsystem is initialized, they run on that many worker threads instead,
+ * although a timer's callback never runs again before it has returned.
+ */
+extern DECLSPEC int SDLCALL SDL_GetTimerStats(SDL_TimerID t, SDL_TimerStats *stats);
+
+/*@}*/
+
+/** @name Frame limiter
+ *  Keeps a loop running at a steady rate, using SDL_DelayPrecise() to
+ *  wait for the start of each frame.
+ */
+/*@{*/
+typedef struct _SDL_FrameLimiter SDL_FrameLimiter;
+
+/** Statistics for a frame limiter, with times in microseconds */
+typedef struct SDL_FrameStats {
+	Uint32 frames;		/**< Frames waited for */
+	Uint32 missed;		/**< Frames that started late */
+	Uint32 frame_avg;	/**< Time between frames */
+	Uint32 jitter_avg;	/**< Time from the deadline to the frame */
+	Uint32 jitter_max;
+} SDL_FrameStats;
+
+/**
+ * Create a frame limiter for 'rate' frames per second.
+ * The first frame is due one frame after the limiter is created.
+ * Returns NULL, setting the error message, if the rate isn't positive.
+ */
+extern DECLSPEC SDL_FrameLimiter * SDLCALL SDL_CreateFrameLimiter(double rate);
+
+/**
+ * Wait for the start of the next frame.  Frames are scheduled a fixed
+ * period apart, so the rate doesn't drift, but if the loop falls more
+ * than a frame behind the schedule starts over instead of rushing to
+ * catch up.
+ */
+extern DECLSPEC void SDLCALL SDL_FrameLimiterWait(SDL_FrameLimiter *limiter);
+
+/** Get the statistics of a frame limiter since it was created or reset */
+extern DECLSPEC void SDLCALL SDL_GetFrameStats(SDL_FrameLimiter *limiter, SDL_FrameStats *stats);
+
+/** Clear the statistics of a frame limiter */
+extern DECLSPEC void SDLCALL SDL_ResetFrameStats(SDL_FrameLimiter *limiter);
+
+extern DECLSPEC void SDLCALL SDL_FreeFrameLimiter(SDL_FrameLimiter *limiter);
 /*@}*/
 
 /* Ends C function definitions when using C++ */
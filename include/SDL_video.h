@@ -390,6 +390,9 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_SetVideoMode
 /*@{*/
 /**
  * Makes sure the given list of rectangles is updated on the given screen.
+ * Overlapping and nearby rectangles are merged, and larger overlaps split,
+ * so that each pixel is copied to the display once and the number of
+ * rectangles pushed to the driver stays reasonable.
  */
 extern DECLSPEC void SDLCALL SDL_UpdateRects
 		(SDL_Surface *screen, int numrects, SDL_Rect *rects);
@@ -399,6 +402,55 @@ extern DECLSPEC void SDLCALL SDL_UpdateRects
  */
 extern DECLSPEC void SDLCALL SDL_UpdateRect
 		(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h);
+
+/** Counters for the work done by SDL_UpdateRects() */
+typedef struct SDL_UpdateStats {
+	Uint32 updates;		/**< Calls to SDL_UpdateRects() */
+	Uint32 rects_in;	/**< Rectangles passed in */
+	Uint32 rects_out;	/**< Rectangles actually updated */
+	Uint32 pixels_in;	/**< Pixels covered by the rectangles passed in */
+	Uint32 pixels_out;	/**< Pixels actually updated */
+	Uint32 bytes_saved;	/**< Bytes not copied because of merging */
+} SDL_UpdateStats;
+
+/**
+ * Get the update counters since the video mode was set, or since they
+ * were last reset.  The counters wrap around, so reset them regularly
+ * when measuring over long periods.
+ */
+extern DECLSPEC void SDLCALL SDL_GetUpdateStats(SDL_UpdateStats *stats);
+extern DECLSPEC void SDLCALL SDL_ResetUpdateStats(void);
+
+/**
+ * Turns automatic damage tracking on the display surface on or off.
+ * While it is on, blits, SDL_FillRect(), SDL_FillRects() and stretches to
+ * the screen record the area they change, and locking the screen records
+ * the whole screen.  Pixels written without locking the screen aren't seen.
+ * Tracking is turned off by SDL_SetVideoMode(), and is not available for
+ * OpenGL modes.
+ * This function returns 0 if successful, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_SetDamageTracking(SDL_Surface *screen, int enable);
+/**
+ * Updates the areas of the screen changed since the last call, and clears
+ * the recorded damage.  Without damage tracking the entire screen is
+ * updated.  SDL_Flip() calls this when there is no second video buffer.
+ */
+extern DECLSPEC void SDLCALL SDL_UpdateDamage(SDL_Surface *screen);
+
+/** Called with the video surface and the rectangles the driver updated */
+typedef void (SDLCALL *SDL_FrameCallback)(void *userdata, SDL_Surface *frame,
+					int numrects, const SDL_Rect *rects);
+
+/**
+ * Sets a function to be called each time the video driver updates the
+ * display, or NULL to remove it.  This lets headless programs look at what
+ * would have been shown.  The callback may be called from another thread
+ * while SDL_VIDEO_ASYNC_PRESENT is in effect, and must not call SDL video
+ * functions.  Only the dummy video driver supports this at the moment.
+ * This function returns 0 if successful, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_SetFrameCallback(SDL_FrameCallback callback, void *userdata);
 /*@}*/
 
 /**
@@ -603,6 +655,38 @@ extern DECLSPEC int SDLCALL SDL_SaveBMP_RW
 #define SDL_SaveBMP(surface, file) \
 		SDL_SaveBMP_RW(surface, SDL_RWFromFile(file, "wb"), 1)
 
+/**
+ * Save the RLE encoding of a surface to an SDL data source, so that it
+ * can be loaded with SDL_LoadRLE_RW() instead of encoding the surface
+ * again.  The surface must have been RLE encoded, which happens when it
+ * is first blitted after SDL_RLEACCEL was requested.
+ * The data is only usable on a machine with the same byte order.
+ * If 'freedst' is non-zero, the source will be closed after being written.
+ * Returns 0 if successful or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_SaveRLE_RW
+		(SDL_Surface *surface, SDL_RWops *dst, int freedst);
+
+/** Convenience macro -- save the RLE encoding of a surface to a file */
+#define SDL_SaveRLE(surface, file) \
+		SDL_SaveRLE_RW(surface, SDL_RWFromFile(file, "wb"), 1)
+
+/**
+ * Load an RLE encoding saved by SDL_SaveRLE_RW() for a surface with the
+ * same size, format and pixels.  The next time the surface is RLE encoded
+ * with the same color key (or, for surfaces with an alpha channel, for
+ * the same destination format) the loaded encoding is used instead.
+ * It is discarded if the surface is locked before that.
+ * If 'freesrc' is non-zero, the source will be closed after being read.
+ * Returns 0 if successful or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_LoadRLE_RW
+		(SDL_Surface *surface, SDL_RWops *src, int freesrc);
+
+/** Convenience macro -- load the RLE encoding of a surface from a file */
+#define SDL_LoadRLE(surface, file) \
+		SDL_LoadRLE_RW(surface, SDL_RWFromFile(file, "rb"), 1)
+
 /**
  * Sets the color key (transparent pixel) in a blittable surface.
  * If 'flag' is SDL_SRCCOLORKEY (optionally OR'd with SDL_RLEACCEL), 
@@ -755,6 +839,33 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 			(SDL_Surface *src, SDL_Rect *srcrect,
 			 SDL_Surface *dst, SDL_Rect *dstrect);
 
+/** @name Blitter CPU Requirements
+ *  The CPU features needed by a blitter reported by SDL_GetBlitInfo()
+ */
+/*@{*/
+#define SDL_BLITCPU_MMX		0x00000001
+#define SDL_BLITCPU_3DNOW	0x00000002
+#define SDL_BLITCPU_SSE		0x00000004
+#define SDL_BLITCPU_SSE2	0x00000008
+#define SDL_BLITCPU_ALTIVEC	0x00000010
+#define SDL_BLITCPU_ARMSIMD	0x00000020
+#define SDL_BLITCPU_ARMNEON	0x00000040
+/*@}*/
+
+/**
+ * Reports how SDL blits 'src' onto 'dst' with the current surface flags,
+ * to help find out why a blit is slow.  'method' is set to "hardware",
+ * "rle" or "software", 'kernel' to the name of the routine doing the
+ * work, and 'features' to the SDL_BLITCPU flags that routine needs.
+ * Any of the pointers may be NULL.  Like a blit, this maps 'src' for
+ * blitting to 'dst' if it isn't already.
+ * Setting the environment variable SDL_BLIT_LOG prints the same
+ * information to stderr whenever SDL chooses a blitter.
+ * This function returns 0 if successful, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_GetBlitInfo(SDL_Surface *src, SDL_Surface *dst,
+			const char **method, const char **kernel, Uint32 *features);
+
 /**
  * This function performs a fast fill of the given rectangle with 'color'
  * The given rectangle is clipped to the destination surface clip area
@@ -767,6 +878,18 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 extern DECLSPEC int SDLCALL SDL_FillRect
 		(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
 
+/**
+ * This function fills 'num' rectangles with 'color' in one pass.
+ * Each rectangle is clipped to the destination surface clip area, but
+ * unlike SDL_FillRect() the passed in rectangles are not modified.
+ * The surface is only locked once for the whole batch, so this is faster
+ * than calling SDL_FillRect() in a loop when clearing many small areas.
+ * If 'rects' is NULL, the whole surface will be filled with 'color'
+ * This function returns 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_FillRects
+		(SDL_Surface *dst, const SDL_Rect *rects, int num, Uint32 color);
+
 /**
  * This function takes a surface and copies it to a new surface of the
  * pixel format and colors of the video framebuffer, suitable for fast
@@ -941,7 +1064,33 @@ extern DECLSPEC SDL_GrabMode SDLCALL SDL_WM_GrabInput(SDL_GrabMode mode);
 /** @internal Not in public API at the moment - do not use! */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                                     SDL_Surface *dst, SDL_Rect *dstrect);
-                    
+
+/** Resampling filters for SDL_SoftStretchFilter() */
+typedef enum {
+	SDL_STRETCH_NEAREST,	/**< Pick the closest source pixel */
+	SDL_STRETCH_BILINEAR,	/**< Interpolate between the 4 closest pixels */
+	SDL_STRETCH_AREA	/**< Average the covered pixels (downscaling) */
+} SDL_StretchFilter;
+
+/**
+ * Perform a filtered stretch blit from the source rectangle to the
+ * destination rectangle, converting between pixel formats on the fly.
+ *
+ * Both surfaces must be 16, 24 or 32 bits per pixel, unless the filter
+ * is SDL_STRETCH_NEAREST and the surfaces share the same format.
+ * SDL_STRETCH_AREA behaves like SDL_STRETCH_BILINEAR along an axis that
+ * is being enlarged.  Colorkey and per-surface alpha are ignored, the
+ * pixel values (including alpha) are resampled and copied as-is.
+ *
+ * Like SDL_SoftStretch(), this function may be called from several
+ * threads at once, as long as they don't write to the same surface.
+ *
+ * @return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFilter(SDL_Surface *src, SDL_Rect *srcrect,
+                                    SDL_Surface *dst, SDL_Rect *dstrect,
+                                    SDL_StretchFilter filter);
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
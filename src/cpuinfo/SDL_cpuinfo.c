@@ -36,6 +36,18 @@
 #include <signal.h>
 #include <setjmp.h>
 #endif
+#if defined(_MSC_VER) && (_MSC_VER >= 1500) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>	/* For __cpuidex() and _xgetbv() */
+#endif
+#if defined(__WIN32__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>	/* For GetSystemInfo() */
+#elif defined(__MACOSX__)
+#include <sys/types.h>
+#include <sys/sysctl.h>	/* For the CPU count and cache sizes */
+#elif defined(__unix__) || defined(__LINUX__) || defined(__IRIX__)
+#include <unistd.h>	/* For sysconf() */
+#endif
 
 #define CPU_HAS_RDTSC	0x00000001
 #define CPU_HAS_MMX	0x00000002
@@ -47,6 +59,38 @@
 #define CPU_HAS_ALTIVEC	0x00000100
 #define CPU_HAS_ARM_SIMD 0x00000200
 #define CPU_HAS_ARM_NEON 0x00000400
+#define CPU_HAS_SSE3	0x00000800
+#define CPU_HAS_SSSE3	0x00001000
+#define CPU_HAS_SSE41	0x00002000
+#define CPU_HAS_SSE42	0x00004000
+#define CPU_HAS_AVX	0x00008000
+#define CPU_HAS_AVX2	0x00010000
+#define CPU_HAS_AVX512F	0x00020000
+
+/* The names used by SDL_CPU_MASK, and the order of the x86 SIMD levels */
+static const struct {
+	const char *name;
+	Uint32 feature;
+	int level;
+} CPU_featureNames[] = {
+	{ "rdtsc",    CPU_HAS_RDTSC,    0 },
+	{ "mmx",      CPU_HAS_MMX,      1 },
+	{ "mmxext",   CPU_HAS_MMXEXT,   0 },
+	{ "3dnow",    CPU_HAS_3DNOW,    0 },
+	{ "3dnowext", CPU_HAS_3DNOWEXT, 0 },
+	{ "sse",      CPU_HAS_SSE,      2 },
+	{ "sse2",     CPU_HAS_SSE2,     3 },
+	{ "sse3",     CPU_HAS_SSE3,     4 },
+	{ "ssse3",    CPU_HAS_SSSE3,    5 },
+	{ "sse41",    CPU_HAS_SSE41,    6 },
+	{ "sse42",    CPU_HAS_SSE42,    7 },
+	{ "avx",      CPU_HAS_AVX,      8 },
+	{ "avx2",     CPU_HAS_AVX2,     9 },
+	{ "avx512f",  CPU_HAS_AVX512F,  10 },
+	{ "altivec",  CPU_HAS_ALTIVEC,  0 },
+	{ "armsimd",  CPU_HAS_ARM_SIMD, 0 },
+	{ "neon",     CPU_HAS_ARM_NEON, 0 }
+};
 
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__ && !__OpenBSD__
 /* This is the brute force way of detecting instruction sets...
@@ -307,6 +351,114 @@ done:
 	return features;
 }
 
+/* Run CPUID for a leaf and subleaf, leaving zeroes if it can't */
+static void CPU_cpuid(Uint32 leaf, Uint32 subleaf, Uint32 regs[4])
+{
+	regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#if defined(__GNUC__) && defined(i386)
+	__asm__ __volatile__ (
+"        movl    %%ebx,%%esi         # EBX may be the PIC register     \n"
+"        cpuid                                                         \n"
+"        xchgl   %%ebx,%%esi                                           \n"
+	: "=a" (regs[0]), "=S" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+	: "a" (leaf), "c" (subleaf)
+	);
+#elif defined(__GNUC__) && defined(__x86_64__)
+	__asm__ __volatile__ (
+"        movq    %%rbx,%%rsi         # RBX may be the PIC register     \n"
+"        cpuid                                                         \n"
+"        xchgq   %%rbx,%%rsi                                           \n"
+	: "=a" (regs[0]), "=S" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+	: "a" (leaf), "c" (subleaf)
+	);
+#elif defined(_MSC_VER) && (_MSC_VER >= 1500) && (defined(_M_IX86) || defined(_M_X64))
+	__cpuidex((int *)regs, (int)leaf, (int)subleaf);
+#endif
+}
+
+/* The register state the OS saves on context switches, from XGETBV */
+static Uint32 CPU_getXCR0(void)
+{
+	Uint32 xcr0 = 0;
+#if defined(__GNUC__) && (defined(i386) || defined(__x86_64__))
+	Uint32 high;
+	__asm__ __volatile__ (
+"        .byte   0x0f,0x01,0xd0      # xgetbv                          \n"
+	: "=a" (xcr0), "=d" (high)
+	: "c" (0)
+	);
+#elif defined(_MSC_VER) && (_MSC_VER >= 1600) && (defined(_M_IX86) || defined(_M_X64))
+	xcr0 = (Uint32)_xgetbv(0);
+#endif
+	return xcr0;
+}
+
+/* The SSE3 and later features, which need the newer CPUID leaves */
+static Uint32 CPU_getX86Features(void)
+{
+	Uint32 regs[4];
+	Uint32 max_leaf;
+	Uint32 xcr0 = 0;
+	Uint32 features = 0;
+
+	if ( !CPU_haveCPUID() ) {
+		return 0;
+	}
+	CPU_cpuid(0, 0, regs);
+	max_leaf = regs[0];
+	if ( max_leaf < 1 ) {
+		return 0;
+	}
+	CPU_cpuid(1, 0, regs);
+	if ( regs[2] & 0x00000001 ) {
+		features |= CPU_HAS_SSE3;
+	}
+	if ( regs[2] & 0x00000200 ) {
+		features |= CPU_HAS_SSSE3;
+	}
+	if ( regs[2] & 0x00080000 ) {
+		features |= CPU_HAS_SSE41;
+	}
+	if ( regs[2] & 0x00100000 ) {
+		features |= CPU_HAS_SSE42;
+	}
+	/* AVX also needs the OS to save the YMM registers */
+	if ( regs[2] & 0x08000000 ) {
+		xcr0 = CPU_getXCR0();
+	}
+	if ( (regs[2] & 0x10000000) && (xcr0 & 0x06) == 0x06 ) {
+		features |= CPU_HAS_AVX;
+	}
+	if ( (features & CPU_HAS_AVX) && max_leaf >= 7 ) {
+		CPU_cpuid(7, 0, regs);
+		if ( regs[1] & 0x00000020 ) {
+			features |= CPU_HAS_AVX2;
+		}
+		/* ... and AVX-512 the opmask and ZMM registers */
+		if ( (regs[1] & 0x00010000) && (xcr0 & 0xE6) == 0xE6 ) {
+			features |= CPU_HAS_AVX512F;
+		}
+	}
+	return features;
+}
+
+static int CPU_getCacheLineSize(void)
+{
+	Uint32 regs[4];
+
+	if ( CPU_haveCPUID() ) {
+		CPU_cpuid(0, 0, regs);
+		if ( regs[0] >= 1 ) {
+			CPU_cpuid(1, 0, regs);
+			/* The CLFLUSH line size, in 8 byte units */
+			if ( (regs[3] & 0x00080000) && (regs[1] & 0xFF00) ) {
+				return ((regs[1] >> 8) & 0xFF) * 8;
+			}
+		}
+	}
+	return SDL_CACHELINE_SIZE;
+}
+
 static __inline__ int CPU_haveRDTSC(void)
 {
 	if ( CPU_haveCPUID() ) {
@@ -392,7 +544,7 @@ static __inline__ int CPU_haveAltiVec(void)
 	return altivec; 
 }
 
-#ifdef __linux__
+#if defined(__linux__) && defined(__arm__)
 
 #include <unistd.h>
 #include <sys/types.h>
@@ -492,6 +644,58 @@ static __inline__ int CPU_haveARMNEON(void)
 
 #endif
 
+/* Work out which features are left on by SDL_CPU_MASK, a comma separated
+   list of feature names.  "-name" turns that feature off, a plain x86 SIMD
+   name turns off every later x86 SIMD level, and "none" turns off all.
+ */
+static Uint32 CPU_getFeatureMask(const char *spec)
+{
+	Uint32 mask = 0xFFFFFFFF;
+	char name[16];
+	int disable;
+	size_t len;
+	int i, j;
+
+	while ( spec && *spec ) {
+		while ( *spec == ',' || *spec == ' ' ) {
+			++spec;
+		}
+		disable = (*spec == '-');
+		if ( disable ) {
+			++spec;
+		}
+		for ( len = 0; *spec && *spec != ',' && *spec != ' '; ++spec ) {
+			if ( len < sizeof(name)-1 ) {
+				name[len++] = *spec;
+			}
+		}
+		name[len] = '\0';
+		if ( len == 0 ) {
+			continue;
+		}
+		if ( SDL_strcasecmp(name, "none") == 0 ) {
+			mask = CPU_HAS_RDTSC;
+			continue;
+		}
+		for ( i = 0; i < SDL_arraysize(CPU_featureNames); ++i ) {
+			if ( SDL_strcasecmp(name, CPU_featureNames[i].name) != 0 ) {
+				continue;
+			}
+			if ( disable ) {
+				mask &= ~CPU_featureNames[i].feature;
+			} else if ( CPU_featureNames[i].level ) {
+				for ( j = 0; j < SDL_arraysize(CPU_featureNames); ++j ) {
+					if ( CPU_featureNames[j].level > CPU_featureNames[i].level ) {
+						mask &= ~CPU_featureNames[j].feature;
+					}
+				}
+			}
+			break;
+		}
+	}
+	return mask;
+}
+
 static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
 
 static Uint32 SDL_GetCPUFeatures(void)
@@ -528,10 +732,238 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveARMNEON() ) {
 			SDL_CPUFeatures |= CPU_HAS_ARM_NEON;
 		}
+		SDL_CPUFeatures |= CPU_getX86Features();
+
+		/* Let benchmarks and bug reports pin the code paths used */
+		SDL_CPUFeatures &= CPU_getFeatureMask(SDL_getenv("SDL_CPU_MASK"));
 	}
 	return SDL_CPUFeatures;
 }
 
+/* Add up the caches CPUID describes, by level */
+static void CPU_getCacheSizes(int sizes[4])
+{
+	Uint32 regs[4];
+	Uint32 max_leaf, level, size;
+	int intel;
+	int i;
+
+	if ( !CPU_haveCPUID() ) {
+		return;
+	}
+	CPU_cpuid(0, 0, regs);
+	max_leaf = regs[0];
+	intel = (regs[1] == 0x756E6547 && regs[3] == 0x49656E69 &&
+	         regs[2] == 0x6C65746E);	/* "GenuineIntel" */
+	if ( intel && max_leaf >= 4 ) {
+		/* Deterministic cache parameters, one subleaf per cache */
+		for ( i = 0; i < 16; ++i ) {
+			CPU_cpuid(4, i, regs);
+			if ( (regs[0] & 0x1F) == 0 ) {
+				break;
+			}
+			if ( (regs[0] & 0x1F) == 2 ) {
+				continue;	/* instruction cache */
+			}
+			level = (regs[0] >> 5) & 0x7;
+			size = (((regs[1] >> 22) & 0x3FF) + 1) *
+			       (((regs[1] >> 12) & 0x3FF) + 1) *
+			       ((regs[1] & 0xFFF) + 1) * (regs[2] + 1);
+			if ( level >= 1 && level <= 3 ) {
+				sizes[level] = (int)size;
+			}
+		}
+		return;
+	}
+
+	/* AMD and others describe L1 to L3 in the extended leaves */
+	CPU_cpuid(0x80000000, 0, regs);
+	max_leaf = regs[0];
+	if ( max_leaf >= 0x80000005 ) {
+		CPU_cpuid(0x80000005, 0, regs);
+		sizes[1] = (int)(regs[2] >> 24) * 1024;
+	}
+	if ( max_leaf >= 0x80000006 ) {
+		CPU_cpuid(0x80000006, 0, regs);
+		sizes[2] = (int)(regs[2] >> 16) * 1024;
+		sizes[3] = (int)(regs[3] >> 18) * 512 * 1024;
+	}
+}
+
+#if defined(__LINUX__)
+/* Read the first line of a sysfs file, returns 0 if there isn't one */
+static int CPU_readSysfs(const char *path, char *buf, int len)
+{
+	FILE *fp;
+	int ok = 0;
+
+	fp = fopen(path, "r");
+	if ( fp ) {
+		ok = (fgets(buf, len, fp) != NULL);
+		fclose(fp);
+	}
+	return ok;
+}
+
+static int CPU_getLinuxCacheSizes(int sizes[4])
+{
+	char path[128], buf[32];
+	int found = 0;
+	int i, level, size;
+
+	for ( i = 0; i < 16; ++i ) {
+		SDL_snprintf(path, sizeof(path),
+		     "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+		if ( !CPU_readSysfs(path, buf, sizeof(buf)) ) {
+			break;
+		}
+		level = SDL_atoi(buf);
+		SDL_snprintf(path, sizeof(path),
+		     "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+		if ( !CPU_readSysfs(path, buf, sizeof(buf)) ||
+		     SDL_strncmp(buf, "Instruction", 11) == 0 ) {
+			continue;
+		}
+		SDL_snprintf(path, sizeof(path),
+		     "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+		if ( !CPU_readSysfs(path, buf, sizeof(buf)) ) {
+			continue;
+		}
+		size = SDL_atoi(buf);
+		if ( SDL_strchr(buf, 'K') ) {
+			size *= 1024;
+		} else if ( SDL_strchr(buf, 'M') ) {
+			size *= 1024 * 1024;
+		}
+		if ( level >= 1 && level <= 3 && size > 0 ) {
+			sizes[level] = size;
+			found = 1;
+		}
+	}
+	return found;
+}
+
+/* Count the CPUs that come first in their list of hyperthread siblings */
+static int CPU_getLinuxCoreCount(int cpus)
+{
+	char path[128], buf[64];
+	int cores = 0;
+	int i;
+
+	for ( i = 0; i < cpus; ++i ) {
+		SDL_snprintf(path, sizeof(path),
+		     "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", i);
+		if ( !CPU_readSysfs(path, buf, sizeof(buf)) ) {
+			return 0;
+		}
+		if ( SDL_atoi(buf) == i ) {
+			++cores;
+		}
+	}
+	return cores;
+}
+#endif /* __LINUX__ */
+
+#if defined(__MACOSX__)
+static int CPU_sysctl(const char *name)
+{
+	Uint64 value = 0;
+	size_t size = sizeof(value);
+
+	if ( sysctlbyname(name, &value, &size, NULL, 0) != 0 ) {
+		return 0;
+	}
+	/* The result is 32 or 64 bits wide depending on the name */
+	if ( size == sizeof(Uint32) ) {
+		Uint32 value32;
+		SDL_memcpy(&value32, &value, sizeof(value32));
+		return (int)value32;
+	}
+	return (int)value;
+}
+#endif
+
+static int SDL_CPUCount = 0;
+static int SDL_CPUCoreCount = 0;
+static volatile int SDL_CPUCacheSizes[4] = { -1, 0, 0, 0 };
+
+int SDL_GetCPUCount(void)
+{
+	if ( !SDL_CPUCount ) {
+#if defined(__WIN32__)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		SDL_CPUCount = (int)info.dwNumberOfProcessors;
+#elif defined(__MACOSX__)
+		SDL_CPUCount = CPU_sysctl("hw.logicalcpu");
+#elif defined(__IRIX__)
+		SDL_CPUCount = (int)sysconf(_SC_NPROC_ONLN);
+#elif defined(_SC_NPROCESSORS_ONLN)
+		SDL_CPUCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		if ( SDL_CPUCount <= 0 ) {
+			SDL_CPUCount = 1;
+		}
+	}
+	return SDL_CPUCount;
+}
+
+int SDL_GetCPUCoreCount(void)
+{
+	if ( !SDL_CPUCoreCount ) {
+#if defined(__LINUX__)
+		SDL_CPUCoreCount = CPU_getLinuxCoreCount(SDL_GetCPUCount());
+#elif defined(__MACOSX__)
+		SDL_CPUCoreCount = CPU_sysctl("hw.physicalcpu");
+#endif
+		if ( SDL_CPUCoreCount <= 0 ||
+		     SDL_CPUCoreCount > SDL_GetCPUCount() ) {
+			SDL_CPUCoreCount = SDL_GetCPUCount();
+		}
+	}
+	return SDL_CPUCoreCount;
+}
+
+int SDL_GetCPUCacheSize(int level)
+{
+	if ( SDL_CPUCacheSizes[0] < 0 ) {
+		/* Fill a local copy and publish it last, so that another
+		   thread never sees the table half filled in. */
+		int sizes[4] = { 0, 0, 0, 0 };
+		int found = 0;
+
+#if defined(__LINUX__)
+		found = CPU_getLinuxCacheSizes(sizes);
+#elif defined(__MACOSX__)
+		sizes[1] = CPU_sysctl("hw.l1dcachesize");
+		sizes[2] = CPU_sysctl("hw.l2cachesize");
+		sizes[3] = CPU_sysctl("hw.l3cachesize");
+		found = (sizes[1] > 0);
+#endif
+		if ( !found ) {
+			CPU_getCacheSizes(sizes);
+		}
+		SDL_CPUCacheSizes[1] = sizes[1];
+		SDL_CPUCacheSizes[2] = sizes[2];
+		SDL_CPUCacheSizes[3] = sizes[3];
+		SDL_CPUCacheSizes[0] = 0;
+	}
+	if ( level < 1 || level > 3 ) {
+		return 0;
+	}
+	return SDL_CPUCacheSizes[level];
+}
+
+static int SDL_CPUCacheLineSize = 0;
+
+int SDL_GetCPUCacheLineSize(void)
+{
+	if ( !SDL_CPUCacheLineSize ) {
+		SDL_CPUCacheLineSize = CPU_getCacheLineSize();
+	}
+	return SDL_CPUCacheLineSize;
+}
+
 SDL_bool SDL_HasRDTSC(void)
 {
 	if ( SDL_GetCPUFeatures() & CPU_HAS_RDTSC ) {
@@ -588,6 +1020,62 @@ SDL_bool SDL_HasSSE2(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSSE3 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSE41(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE41 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasSSE42(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE42 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX2(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX2 ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+SDL_bool SDL_HasAVX512F(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX512F ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
 SDL_bool SDL_HasAltiVec(void)
 {
 	if ( SDL_GetCPUFeatures() & CPU_HAS_ALTIVEC ) {
@@ -625,9 +1113,22 @@ int main()
 	printf("3DNowExt: %d\n", SDL_Has3DNowExt());
 	printf("SSE: %d\n", SDL_HasSSE());
 	printf("SSE2: %d\n", SDL_HasSSE2());
+	printf("SSE3: %d\n", SDL_HasSSE3());
+	printf("SSSE3: %d\n", SDL_HasSSSE3());
+	printf("SSE4.1: %d\n", SDL_HasSSE41());
+	printf("SSE4.2: %d\n", SDL_HasSSE42());
+	printf("AVX: %d\n", SDL_HasAVX());
+	printf("AVX2: %d\n", SDL_HasAVX2());
+	printf("AVX-512F: %d\n", SDL_HasAVX512F());
 	printf("AltiVec: %d\n", SDL_HasAltiVec());
 	printf("ARM SIMD: %d\n", SDL_HasARMSIMD());
 	printf("ARM NEON: %d\n", SDL_HasARMNEON());
+	printf("Cache line size: %d\n", SDL_GetCPUCacheLineSize());
+	printf("L1 cache: %d\n", SDL_GetCPUCacheSize(1));
+	printf("L2 cache: %d\n", SDL_GetCPUCacheSize(2));
+	printf("L3 cache: %d\n", SDL_GetCPUCacheSize(3));
+	printf("CPUs: %d\n", SDL_GetCPUCount());
+	printf("Cores: %d\n", SDL_GetCPUCoreCount());
 	return 0;
 }
 
@@ -28,6 +28,7 @@
 #include "SDL_sysevents.h"
 #include "SDL_events_c.h"
 #include "../timer/SDL_timer_c.h"
+#include "../thread/SDL_atomic_c.h"
 #if !SDL_JOYSTICK_DISABLED
 #include "../joystick/SDL_joystick_c.h"
 #endif
@@ -37,18 +38,80 @@ SDL_EventFilter SDL_EventOK = NULL;
 Uint8 SDL_ProcessEvents[SDL_NUMEVENTS];
 static Uint32 SDL_eventstate = 0;
 
-/* Private data -- event queue */
-#define MAXEVENTS	128
+/* Private data -- event queue
+
+   Events are added without taking the queue lock: each one is copied into
+   a node which is pushed on the 'pending' list with a compare-and-swap.
+   SDL_PeepEvents() takes the lock, moves the pending events in order to
+   the end of a ring that grows as needed, and looks at them there.
+   'count' is the number of events in both places, and is kept at or below
+   'maxevents'.
+
+   Each event type has a list of its events in the ring, linked through
+   'next', so events matching a mask are found without looking at the
+   others.  Events taken from the middle of the ring are only marked as
+   removed; the ring skips them at either end and packs the rest when it
+   fills up.
+ */
+#define DEFAULT_MAXEVENTS	65536
+#define MINEVENTS	128	/* Initial size of the ring */
+#define REMOVED		-2	/* 'next' of an event taken from the ring */
+#define EVENT_LIST(type)	((type) & (SDL_NUMEVENTS-1))
+#define COALESCE_MASK	(SDL_MOUSEMOTIONMASK|SDL_VIDEORESIZEMASK|SDL_VIDEOEXPOSEMASK)
+
+/* Events are stamped with SDL_GetPerformanceCounter() when they're added */
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Uint64 SDL_EventTime;
+#define SDL_GetEventClock()	SDL_GetPerformanceCounter()
+#else
+typedef Uint32 SDL_EventTime;
+#define SDL_GetEventClock()	SDL_GetTicks()
+#endif
+
+typedef struct SDL_EventNode {
+	SDL_Event event;
+	SDL_EventTime time;
+	SDL_SysWMmsg msg;
+	struct SDL_EventNode *next;
+} SDL_EventNode;
+
 static struct {
 	SDL_mutex *lock;
 	int active;
+	void * volatile pending;	/* SDL_EventNode list, newest first */
+	volatile int count;
+	int maxevents;
 	int head;
 	int tail;
-	SDL_Event event[MAXEVENTS];
-	int wmmsg_next;
-	struct SDL_SysWMmsg wmmsg[MAXEVENTS];
+	int size;
+	int used;		/* Events in the ring, not counting removed ones */
+	SDL_Event *event;
+	SDL_EventTime *time;	/* When each event was added */
+	SDL_SysWMmsg *msg;	/* The window manager message of each event */
+	int *next;		/* Next event of the same type, or -1 */
+	int first[SDL_NUMEVENTS];
+	int last[SDL_NUMEVENTS];
+	volatile int peak;
+	volatile int pushed;
+	volatile int dropped;
+	volatile int merged;
+	Uint32 coalesce;	/* Types merged into the last event queued */
+	SDL_EventTime last_time;	/* Time of the last event removed */
+	volatile int waiting;	/* Threads in SDL_WaitForEvents() */
+	SDL_mutex *wait_lock;
+	SDL_cond *wait_cond;
 } SDL_EventQ;
 
+#if SDL_HAS_ATOMICS
+#define EVENTQ_ADD(var, value)	SDL_AtomicAdd(&SDL_EventQ.var, value)
+#else
+/* Without atomic operations events are added with the queue locked */
+#define EVENTQ_ADD(var, value)	((SDL_EventQ.var += (value)) - (value))
+#endif
+
+static SDL_EventNode *SDL_TakePending(void);
+static void SDL_FreePending(SDL_EventNode *node);
+
 /* Private data -- event locking structure */
 static struct {
 	SDL_mutex *lock;
@@ -107,6 +170,14 @@ static int SDLCALL SDL_GobbleEvents(void *unused)
 			video->PumpEvents(this);
 		}
 
+		/* Queue the quit event if we were interrupted */
+		SDL_CheckQuit();
+
+		/* Queue recorded events that are due */
+		if ( SDL_event_replaying ) {
+			SDL_CheckReplay();
+		}
+
 		/* Queue pending key-repeat events */
 		SDL_CheckKeyRepeat();
 
@@ -157,6 +228,15 @@ static int SDL_StartEventThread(Uint32 flags)
 		return(-1);
 #endif
 	}
+	SDL_EventQ.wait_lock = SDL_CreateMutex();
+	SDL_EventQ.wait_cond = SDL_CreateCond();
+	if ( !SDL_EventQ.wait_lock || !SDL_EventQ.wait_cond ) {
+		/* SDL_WaitForEvents() will poll instead */
+		if ( SDL_EventQ.wait_cond ) {
+			SDL_DestroyCond(SDL_EventQ.wait_cond);
+			SDL_EventQ.wait_cond = NULL;
+		}
+	}
 #endif /* !SDL_THREADS_DISABLED */
 	SDL_EventQ.active = 1;
 
@@ -197,6 +277,14 @@ static void SDL_StopEventThread(void)
 	SDL_DestroyMutex(SDL_EventQ.lock);
 	SDL_EventQ.lock = NULL;
 #endif
+	if ( SDL_EventQ.wait_cond ) {
+		SDL_DestroyCond(SDL_EventQ.wait_cond);
+		SDL_EventQ.wait_cond = NULL;
+	}
+	if ( SDL_EventQ.wait_lock ) {
+		SDL_DestroyMutex(SDL_EventQ.wait_lock);
+		SDL_EventQ.wait_lock = NULL;
+	}
 }
 
 Uint32 SDL_EventThreadID(void)
@@ -208,6 +296,8 @@ Uint32 SDL_EventThreadID(void)
 
 void SDL_StopEventLoop(void)
 {
+	int i;
+
 	/* Halt the event thread, if running */
 	SDL_StopEventThread();
 
@@ -216,11 +306,36 @@ void SDL_StopEventLoop(void)
 	SDL_KeyboardQuit();
 	SDL_MouseQuit();
 	SDL_QuitQuit();
+	SDL_RecordQuit();
 
 	/* Clean out EventQ */
+	SDL_FreePending(SDL_TakePending());
+	if ( SDL_EventQ.event ) {
+		SDL_free(SDL_EventQ.event);
+		SDL_EventQ.event = NULL;
+	}
+	if ( SDL_EventQ.time ) {
+		SDL_free(SDL_EventQ.time);
+		SDL_EventQ.time = NULL;
+	}
+	if ( SDL_EventQ.msg ) {
+		SDL_free(SDL_EventQ.msg);
+		SDL_EventQ.msg = NULL;
+	}
+	if ( SDL_EventQ.next ) {
+		SDL_free(SDL_EventQ.next);
+		SDL_EventQ.next = NULL;
+	}
+	SDL_EventQ.count = 0;
 	SDL_EventQ.head = 0;
 	SDL_EventQ.tail = 0;
-	SDL_EventQ.wmmsg_next = 0;
+	SDL_EventQ.size = 0;
+	SDL_EventQ.used = 0;
+	SDL_EventQ.last_time = 0;
+	for ( i=0; i<SDL_NUMEVENTS; ++i ) {
+		SDL_EventQ.first[i] = -1;
+		SDL_EventQ.last[i] = -1;
+	}
 }
 
 /* This function (and associated calls) may be called more than once */
@@ -231,8 +346,24 @@ int SDL_StartEventLoop(Uint32 flags)
 	/* Clean out the event queue */
 	SDL_EventThread = NULL;
 	SDL_EventQ.lock = NULL;
+	SDL_EventQ.wait_lock = NULL;
+	SDL_EventQ.wait_cond = NULL;
 	SDL_StopEventLoop();
 
+	/* Size the queue and reset its counters */
+	if ( SDL_EventQ.maxevents == 0 ) {
+		const char *env = SDL_getenv("SDL_EVENT_QUEUE_SIZE");
+		if ( env && (SDL_atoi(env) > 0) ) {
+			SDL_EventQ.maxevents = SDL_atoi(env);
+		} else {
+			SDL_EventQ.maxevents = DEFAULT_MAXEVENTS;
+		}
+	}
+	SDL_EventQ.peak = 0;
+	SDL_EventQ.pushed = 0;
+	SDL_EventQ.dropped = 0;
+	SDL_EventQ.merged = 0;
+
 	/* No filter to start with, process most event types */
 	SDL_EventOK = NULL;
 	SDL_memset(SDL_ProcessEvents,SDL_ENABLE,sizeof(SDL_ProcessEvents));
@@ -247,6 +378,7 @@ int SDL_StartEventLoop(Uint32 flags)
 	retcode += SDL_KeyboardInit();
 	retcode += SDL_MouseInit();
 	retcode += SDL_QuitInit();
+	retcode += SDL_RecordInit();
 	if ( retcode < 0 ) {
 		/* We don't expect them to fail, but... */
 		return(-1);
@@ -261,100 +393,415 @@ int SDL_StartEventLoop(Uint32 flags)
 }
 
 
-/* Add an event to the event queue -- called with the queue locked */
-static int SDL_AddEvent(SDL_Event *event)
+/* Wake up the threads waiting in SDL_WaitForEvents() */
+static void SDL_WakeWaiters(void)
 {
-	int tail, added;
+	SDL_VideoDevice *video = current_video;
 
-	tail = (SDL_EventQ.tail+1)%MAXEVENTS;
-	if ( tail == SDL_EventQ.head ) {
+	if ( video && video->WakeEvents ) {
+		video->WakeEvents(video);
+	}
+	if ( SDL_EventQ.wait_cond ) {
+		SDL_mutexP(SDL_EventQ.wait_lock);
+		SDL_CondBroadcast(SDL_EventQ.wait_cond);
+		SDL_mutexV(SDL_EventQ.wait_lock);
+	}
+}
+
+/* Add an event to the pending list */
+static int SDL_AddEvent(SDL_Event *event, SDL_EventTime time)
+{
+	SDL_EventNode *node;
+	int count, peak;
+
+	count = EVENTQ_ADD(count, 1) + 1;
+	if ( count > SDL_EventQ.maxevents ) {
+		node = NULL;
+	} else {
+		node = (SDL_EventNode *)SDL_malloc(sizeof(*node));
+	}
+	if ( node == NULL ) {
 		/* Overflow, drop event */
-		added = 0;
+		EVENTQ_ADD(count, -1);
+		EVENTQ_ADD(dropped, 1);
+		return(0);
+	}
+	node->event = *event;
+	node->time = time;
+	if ( event->type == SDL_SYSWMEVENT ) {
+		node->msg = *event->syswm.msg;
+	}
+#if SDL_HAS_ATOMICS
+	do {
+		node->next = (SDL_EventNode *)SDL_EventQ.pending;
+	} while ( !SDL_AtomicCASPtr(&SDL_EventQ.pending, node->next, node) );
+#else
+	node->next = (SDL_EventNode *)SDL_EventQ.pending;
+	SDL_EventQ.pending = node;
+#endif
+	EVENTQ_ADD(pushed, 1);
+
+	/* Wake up anyone waiting for an event */
+	if ( SDL_EventQ.waiting ) {
+		SDL_WakeWaiters();
+	}
+
+	/* Remember the longest the queue has been */
+	peak = SDL_EventQ.peak;
+	while ( count > peak ) {
+#if SDL_HAS_ATOMICS
+		if ( SDL_AtomicCAS(&SDL_EventQ.peak, peak, count) ) {
+			break;
+		}
+		peak = SDL_EventQ.peak;
+#else
+		SDL_EventQ.peak = count;
+		break;
+#endif
+	}
+	return(1);
+}
+
+/* Take the pending list, and return it oldest first */
+static SDL_EventNode *SDL_TakePending(void)
+{
+	SDL_EventNode *node, *next, *list;
+
+#if SDL_HAS_ATOMICS
+	do {
+		node = (SDL_EventNode *)SDL_EventQ.pending;
+	} while ( !SDL_AtomicCASPtr(&SDL_EventQ.pending, node, NULL) );
+#else
+	node = (SDL_EventNode *)SDL_EventQ.pending;
+	SDL_EventQ.pending = NULL;
+#endif
+	list = NULL;
+	while ( node ) {
+		next = node->next;
+		node->next = list;
+		list = node;
+		node = next;
+	}
+	return(list);
+}
+
+static void SDL_FreePending(SDL_EventNode *node)
+{
+	SDL_EventNode *next;
+
+	while ( node ) {
+		next = node->next;
+		SDL_free(node);
+		node = next;
+	}
+}
+
+/* Add the event at 'spot' to the end of its type's list */
+static void SDL_LinkEvent(int spot)
+{
+	int type = EVENT_LIST(SDL_EventQ.event[spot].type);
+
+	SDL_EventQ.next[spot] = -1;
+	if ( SDL_EventQ.last[type] < 0 ) {
+		SDL_EventQ.first[type] = spot;
 	} else {
-		SDL_EventQ.event[SDL_EventQ.tail] = *event;
-		if (event->type == SDL_SYSWMEVENT) {
-			/* Note that it's possible to lose an event */
-			int next = SDL_EventQ.wmmsg_next;
-			SDL_EventQ.wmmsg[next] = *event->syswm.msg;
-		        SDL_EventQ.event[SDL_EventQ.tail].syswm.msg =
-						&SDL_EventQ.wmmsg[next];
-			SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
+		SDL_EventQ.next[SDL_EventQ.last[type]] = spot;
+	}
+	SDL_EventQ.last[type] = spot;
+}
+
+/* Make room for one more event in the ring -- called with the queue locked */
+static int SDL_GrowEvents(void)
+{
+	SDL_Event *event;
+	SDL_EventTime *time;
+	SDL_SysWMmsg *msg;
+	int *next;
+	int i, size, spot;
+
+	if ( SDL_EventQ.size && (SDL_EventQ.tail+1)%SDL_EventQ.size != SDL_EventQ.head ) {
+		return(0);
+	}
+
+	/* Pack the events at the start of a new ring, only growing it if
+	   removed events weren't taking up most of the room */
+	size = SDL_EventQ.size;
+	if ( size == 0 ) {
+		size = MINEVENTS;
+	} else if ( SDL_EventQ.used >= size/2 ) {
+		size *= 2;
+	}
+	event = (SDL_Event *)SDL_malloc(size*sizeof(*event));
+	time = (SDL_EventTime *)SDL_malloc(size*sizeof(*time));
+	msg = (SDL_SysWMmsg *)SDL_malloc(size*sizeof(*msg));
+	next = (int *)SDL_malloc(size*sizeof(*next));
+	if ( (event == NULL) || (time == NULL) || (msg == NULL) ||
+	     (next == NULL) ) {
+		if ( event ) {
+			SDL_free(event);
+		}
+		if ( time ) {
+			SDL_free(time);
+		}
+		if ( msg ) {
+			SDL_free(msg);
+		}
+		if ( next ) {
+			SDL_free(next);
+		}
+		return(-1);
+	}
+	i = 0;
+	for ( spot = SDL_EventQ.head; spot != SDL_EventQ.tail;
+	      spot = (spot+1)%SDL_EventQ.size ) {
+		if ( SDL_EventQ.next[spot] != REMOVED ) {
+			event[i] = SDL_EventQ.event[spot];
+			time[i] = SDL_EventQ.time[spot];
+			if ( event[i].type == SDL_SYSWMEVENT ) {
+				msg[i] = SDL_EventQ.msg[spot];
+				event[i].syswm.msg = &msg[i];
+			}
+			++i;
+		}
+	}
+	if ( SDL_EventQ.event ) {
+		SDL_free(SDL_EventQ.event);
+		SDL_free(SDL_EventQ.time);
+		SDL_free(SDL_EventQ.msg);
+		SDL_free(SDL_EventQ.next);
+	}
+	SDL_EventQ.event = event;
+	SDL_EventQ.time = time;
+	SDL_EventQ.msg = msg;
+	SDL_EventQ.next = next;
+	SDL_EventQ.size = size;
+	SDL_EventQ.head = 0;
+	SDL_EventQ.tail = i;
+
+	/* Rebuild the lists of each type */
+	for ( i=0; i<SDL_NUMEVENTS; ++i ) {
+		SDL_EventQ.first[i] = -1;
+		SDL_EventQ.last[i] = -1;
+	}
+	for ( spot = 0; spot < SDL_EventQ.tail; ++spot ) {
+		SDL_LinkEvent(spot);
+	}
+	return(0);
+}
+
+/* Move the pending events to the ring -- called with the queue locked */
+static void SDL_FlushPending(void)
+{
+	SDL_EventNode *node, *next;
+	SDL_Event *event;
+
+	for ( node = SDL_TakePending(); node; node = next ) {
+		next = node->next;
+		if ( SDL_GrowEvents() < 0 ) {
+			/* Out of memory, drop event */
+			EVENTQ_ADD(count, -1);
+			EVENTQ_ADD(dropped, 1);
+		} else {
+			event = &SDL_EventQ.event[SDL_EventQ.tail];
+			*event = node->event;
+			SDL_EventQ.time[SDL_EventQ.tail] = node->time;
+			if ( event->type == SDL_SYSWMEVENT ) {
+				/* The message stays with the event's place in the ring */
+				SDL_EventQ.msg[SDL_EventQ.tail] = node->msg;
+				event->syswm.msg = &SDL_EventQ.msg[SDL_EventQ.tail];
+			}
+			SDL_LinkEvent(SDL_EventQ.tail);
+			SDL_EventQ.tail = (SDL_EventQ.tail+1)%SDL_EventQ.size;
+			++SDL_EventQ.used;
+		}
+		SDL_free(node);
+	}
+}
+
+/* Cut the first event of its type -- called with the queue locked */
+static void SDL_CutEvent(int spot)
+{
+	int type = EVENT_LIST(SDL_EventQ.event[spot].type);
+	int prev;
+
+	SDL_EventQ.first[type] = SDL_EventQ.next[spot];
+	if ( SDL_EventQ.first[type] < 0 ) {
+		SDL_EventQ.last[type] = -1;
+	}
+	SDL_EventQ.next[spot] = REMOVED;
+	--SDL_EventQ.used;
+	EVENTQ_ADD(count, -1);
+
+	/* Skip removed events at the ends of the ring */
+	while ( (SDL_EventQ.head != SDL_EventQ.tail) &&
+	        (SDL_EventQ.next[SDL_EventQ.head] == REMOVED) ) {
+		SDL_EventQ.head = (SDL_EventQ.head+1)%SDL_EventQ.size;
+	}
+	while ( SDL_EventQ.tail != SDL_EventQ.head ) {
+		prev = (SDL_EventQ.tail+SDL_EventQ.size-1)%SDL_EventQ.size;
+		if ( SDL_EventQ.next[prev] != REMOVED ) {
+			break;
 		}
-		SDL_EventQ.tail = tail;
-		added = 1;
+		SDL_EventQ.tail = prev;
 	}
-	return(added);
 }
 
-/* Cut an event, and return the next valid spot, or the tail */
-/*                           -- called with the queue locked */
-static int SDL_CutEvent(int spot)
+/* Copy out up to 'numevents' events matching 'mask' and the times they
+   were added in queue order, and remove them for SDL_GETEVENT
+   -- called with the queue locked */
+static int SDL_TakeEvents(SDL_Event *events, SDL_EventTime *times,
+                          int numevents, SDL_eventaction action, Uint32 mask)
 {
-	if ( spot == SDL_EventQ.head ) {
-		SDL_EventQ.head = (SDL_EventQ.head+1)%MAXEVENTS;
-		return(SDL_EventQ.head);
-	} else
-	if ( (spot+1)%MAXEVENTS == SDL_EventQ.tail ) {
-		SDL_EventQ.tail = spot;
-		return(SDL_EventQ.tail);
-	} else
-	/* We cut the middle -- shift everything over */
-	{
-		int here, next;
+	int spot[SDL_NUMEVENTS];
+	int i, n, best, dist, bestdist, here, used;
 
-		/* This can probably be optimized with SDL_memcpy() -- careful! */
-		if ( --SDL_EventQ.tail < 0 ) {
-			SDL_EventQ.tail = MAXEVENTS-1;
+	/* Start at the first event of each type in the mask */
+	n = 0;
+	for ( i=0; i<SDL_NUMEVENTS; ++i ) {
+		if ( (mask & SDL_EVENTMASK(i)) && (SDL_EventQ.first[i] >= 0) ) {
+			spot[n++] = SDL_EventQ.first[i];
+		}
+	}
+	used = 0;
+	while ( (used < numevents) && (n > 0) ) {
+		/* The earliest of them is the next one in the queue */
+		best = 0;
+		bestdist = SDL_EventQ.size;
+		for ( i=0; i<n; ++i ) {
+			dist = (spot[i]-SDL_EventQ.head+SDL_EventQ.size)%SDL_EventQ.size;
+			if ( dist < bestdist ) {
+				best = i;
+				bestdist = dist;
+			}
+		}
+		here = spot[best];
+		spot[best] = SDL_EventQ.next[here];
+		if ( events ) {
+			events[used] = SDL_EventQ.event[here];
+		}
+		if ( times ) {
+			times[used] = SDL_EventQ.time[here];
 		}
-		for ( here=spot; here != SDL_EventQ.tail; here = next ) {
-			next = (here+1)%MAXEVENTS;
-			SDL_EventQ.event[here] = SDL_EventQ.event[next];
+		++used;
+		if ( action == SDL_GETEVENT ) {
+			SDL_EventQ.last_time = SDL_EventQ.time[here];
+			SDL_CutEvent(here);
+		}
+		if ( spot[best] < 0 ) {
+			spot[best] = spot[--n];
 		}
-		return(spot);
 	}
-	/* NOTREACHED */
+	return(used);
+}
+
+/* Merge an event into the last event queued, if it has the same type and
+   nothing is pending behind it, returning 1 if it was merged */
+static int SDL_MergeEvent(SDL_Event *event, SDL_EventTime time)
+{
+	SDL_Event *last;
+	int merged, value;
+
+	if ( SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+		return(0);
+	}
+	merged = 0;
+	SDL_FlushPending();
+	if ( (SDL_EventQ.head != SDL_EventQ.tail) && !SDL_EventQ.pending ) {
+		int spot = (SDL_EventQ.tail+SDL_EventQ.size-1)%SDL_EventQ.size;
+		last = &SDL_EventQ.event[spot];
+		if ( last->type == event->type ) {
+			switch (event->type) {
+			    case SDL_MOUSEMOTION:
+				if ( last->motion.which != event->motion.which ) {
+					break;
+				}
+				last->motion.state = event->motion.state;
+				last->motion.x = event->motion.x;
+				last->motion.y = event->motion.y;
+				value = last->motion.xrel + event->motion.xrel;
+				last->motion.xrel = (Sint16)SDL_max(-32768, SDL_min(value, 32767));
+				value = last->motion.yrel + event->motion.yrel;
+				last->motion.yrel = (Sint16)SDL_max(-32768, SDL_min(value, 32767));
+				merged = 1;
+				break;
+			    case SDL_VIDEORESIZE:
+				last->resize = event->resize;
+				merged = 1;
+				break;
+			    case SDL_VIDEOEXPOSE:
+				merged = 1;
+				break;
+			}
+			if ( merged ) {
+				SDL_EventQ.time[spot] = time;
+			}
+		}
+	}
+	SDL_mutexV(SDL_EventQ.lock);
+	if ( merged ) {
+		EVENTQ_ADD(merged, 1);
+	}
+	return(merged);
+}
+
+/* Add an event to the queue, merging it into the last one if we can */
+static int SDL_QueueEvent(SDL_Event *event, SDL_EventTime time)
+{
+	if ( (SDL_EventQ.coalesce & SDL_EVENTMASK(event->type)) &&
+	     SDL_MergeEvent(event, time) ) {
+		return(1);
+	}
+	return(SDL_AddEvent(event, time));
 }
 
 /* Lock the event queue, take a peep at it, and unlock it */
-int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
-								Uint32 mask)
+static int SDL_PeepTimes(SDL_Event *events, SDL_EventTime *times,
+                  int numevents, SDL_eventaction action, Uint32 mask)
 {
+	SDL_EventTime now;
 	int i, used;
 
 	/* Don't look after we've quit */
 	if ( ! SDL_EventQ.active ) {
 		return(-1);
 	}
-	/* Lock the event queue */
 	used = 0;
+	now = 0;
+	if ( (action == SDL_ADDEVENT) && !times ) {
+		now = SDL_GetEventClock();
+	}
+#ifdef SDL_HAS_64BIT_TYPE
+	/* Record the events before the queue is locked, since replaying
+	   them holds the recording lock while it adds events */
+	if ( (action == SDL_ADDEVENT) && SDL_event_recording ) {
+		for ( i=0; i<numevents; ++i ) {
+			SDL_RecordEvent(&events[i], times ? times[i] : now);
+		}
+	}
+#endif
+#if SDL_HAS_ATOMICS
+	/* Events are added without locking the queue */
+	if ( action == SDL_ADDEVENT ) {
+		for ( i=0; i<numevents; ++i ) {
+			used += SDL_QueueEvent(&events[i], times ? times[i] : now);
+		}
+		return(used);
+	}
+#endif
+	/* Lock the event queue */
 	if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
 		if ( action == SDL_ADDEVENT ) {
 			for ( i=0; i<numevents; ++i ) {
-				used += SDL_AddEvent(&events[i]);
+				used += SDL_QueueEvent(&events[i], times ? times[i] : now);
 			}
 		} else {
-			SDL_Event tmpevent;
-			int spot;
-
 			/* If 'events' is NULL, just see if they exist */
 			if ( events == NULL ) {
 				action = SDL_PEEKEVENT;
 				numevents = 1;
-				events = &tmpevent;
-			}
-			spot = SDL_EventQ.head;
-			while ((used < numevents)&&(spot != SDL_EventQ.tail)) {
-				if ( mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type) ) {
-					events[used++] = SDL_EventQ.event[spot];
-					if ( action == SDL_GETEVENT ) {
-						spot = SDL_CutEvent(spot);
-					} else {
-						spot = (spot+1)%MAXEVENTS;
-					}
-				} else {
-					spot = (spot+1)%MAXEVENTS;
-				}
 			}
+			SDL_FlushPending();
+			used = SDL_TakeEvents(events, times, numevents, action, mask);
 		}
 		SDL_mutexV(SDL_EventQ.lock);
 	} else {
@@ -364,6 +811,82 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	return(used);
 }
 
+int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
+								Uint32 mask)
+{
+	return(SDL_PeepTimes(events, NULL, numevents, action, mask));
+}
+
+#ifdef SDL_HAS_64BIT_TYPE
+int SDL_PeepEventTimes(SDL_Event *events, Uint64 *times, int numevents,
+				SDL_eventaction action, Uint32 mask)
+{
+	return(SDL_PeepTimes(events, times, numevents, action, mask));
+}
+
+Uint64 SDL_GetEventTime(void)
+{
+	return(SDL_EventQ.last_time);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
+int SDL_DrainEvents(SDL_Event *events, int numevents, Uint32 mask)
+{
+	int used;
+
+	if ( ! SDL_EventQ.active ) {
+		return(-1);
+	}
+	if ( SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+		SDL_SetError("Couldn't lock event queue");
+		return(-1);
+	}
+	SDL_FlushPending();
+	used = 0;
+	if ( events ) {
+		used = SDL_TakeEvents(events, NULL, numevents, SDL_GETEVENT, mask);
+	}
+	used += SDL_TakeEvents(NULL, NULL, SDL_EventQ.used, SDL_GETEVENT, mask);
+	SDL_mutexV(SDL_EventQ.lock);
+	return(used);
+}
+
+int SDL_SetEventQueueSize(int maxevents)
+{
+	if ( maxevents <= 0 ) {
+		SDL_SetError("Invalid event queue size");
+		return(-1);
+	}
+	SDL_EventQ.maxevents = maxevents;
+	return(0);
+}
+
+void SDL_GetEventQueueStats(SDL_EventQueueStats *stats)
+{
+	stats->queued = SDL_EventQ.count;
+	stats->peak = SDL_EventQ.peak;
+	stats->capacity = SDL_EventQ.maxevents;
+	stats->pushed = SDL_EventQ.pushed;
+	stats->dropped = SDL_EventQ.dropped;
+	stats->merged = SDL_EventQ.merged;
+}
+
+void SDL_ResetEventQueueStats(void)
+{
+	SDL_EventQ.peak = SDL_EventQ.count;
+	SDL_EventQ.pushed = 0;
+	SDL_EventQ.dropped = 0;
+	SDL_EventQ.merged = 0;
+}
+
+Uint32 SDL_SetEventCoalescing(Uint32 mask)
+{
+	Uint32 oldmask = SDL_EventQ.coalesce;
+
+	SDL_EventQ.coalesce = mask & COALESCE_MASK;
+	return(oldmask);
+}
+
 /* Run the system dependent event loops */
 void SDL_PumpEvents(void)
 {
@@ -376,6 +899,14 @@ void SDL_PumpEvents(void)
 			video->PumpEvents(this);
 		}
 
+		/* Queue the quit event if we were interrupted */
+		SDL_CheckQuit();
+
+		/* Queue recorded events that are due */
+		if ( SDL_event_replaying ) {
+			SDL_CheckReplay();
+		}
+
 		/* Queue pending key-repeat events */
 		SDL_CheckKeyRepeat();
 
@@ -388,6 +919,99 @@ void SDL_PumpEvents(void)
 	}
 }
 
+/* Return the milliseconds until SDL_PumpEvents() has to run again, or -1
+   if it only needs to run when the video driver has OS events */
+static int SDL_EventPollInterval(void)
+{
+	SDL_VideoDevice *video = current_video;
+	int interval, repeat, replay;
+
+	interval = -1;
+	if ( SDL_EventThread ) {
+		/* The event thread pumps events */
+		return(interval);
+	}
+	if ( video && !video->WaitEvents ) {
+		interval = 10;
+	}
+#if !SDL_JOYSTICK_DISABLED
+	if ( SDL_numjoysticks && (SDL_eventstate & SDL_JOYEVENTMASK) ) {
+		interval = 10;
+	}
+#endif
+	repeat = SDL_KeyRepeatTimeout();
+	if ( (repeat >= 0) && ((interval < 0) || (repeat < interval)) ) {
+		interval = repeat;
+	}
+	if ( SDL_event_replaying ) {
+		replay = SDL_ReplayTimeout();
+		if ( (replay >= 0) && ((interval < 0) || (replay < interval)) ) {
+			interval = replay;
+		}
+	}
+	return(interval);
+}
+
+/* Block until an event may have arrived, or 'timeout' milliseconds have
+   passed.  A negative timeout waits forever.
+ */
+static void SDL_WaitForEvents(int timeout)
+{
+	SDL_VideoDevice *video = current_video;
+	int interval, waited;
+
+	interval = SDL_EventPollInterval();
+	if ( (interval >= 0) && ((timeout < 0) || (interval < timeout)) ) {
+		timeout = interval;
+	}
+
+	/* Producers check 'waiting' after adding an event, and we check for
+	   events after setting it, so either they wake us or we see it */
+#if SDL_HAS_ATOMICS
+	EVENTQ_ADD(waiting, 1);
+#else
+	SDL_mutexP(SDL_EventQ.lock);
+	++SDL_EventQ.waiting;
+	SDL_mutexV(SDL_EventQ.lock);
+#endif
+	waited = 0;
+	if ( !SDL_EventThread && video && video->WaitEvents ) {
+		if ( SDL_EventQ.count > 0 ) {
+			waited = 1;
+		} else {
+			waited = (video->WaitEvents(video, timeout) == 0);
+		}
+		if ( !waited && ((timeout < 0) || (timeout > 10)) ) {
+			/* The driver has to be polled after all */
+			timeout = 10;
+		}
+	}
+	if ( !waited ) {
+		if ( SDL_EventQ.wait_cond ) {
+			SDL_mutexP(SDL_EventQ.wait_lock);
+			if ( SDL_EventQ.count == 0 ) {
+				if ( timeout < 0 ) {
+					SDL_CondWait(SDL_EventQ.wait_cond,
+					             SDL_EventQ.wait_lock);
+				} else {
+					SDL_CondWaitTimeout(SDL_EventQ.wait_cond,
+					             SDL_EventQ.wait_lock, timeout);
+				}
+			}
+			SDL_mutexV(SDL_EventQ.wait_lock);
+		} else if ( SDL_EventQ.count == 0 ) {
+			SDL_Delay(((timeout < 0) || (timeout > 10)) ? 10 : timeout);
+		}
+	}
+#if SDL_HAS_ATOMICS
+	EVENTQ_ADD(waiting, -1);
+#else
+	SDL_mutexP(SDL_EventQ.lock);
+	--SDL_EventQ.waiting;
+	SDL_mutexV(SDL_EventQ.lock);
+#endif
+}
+
 /* Public functions */
 
 int SDL_PollEvent (SDL_Event *event)
@@ -402,12 +1026,29 @@ int SDL_PollEvent (SDL_Event *event)
 
 int SDL_WaitEvent (SDL_Event *event)
 {
+	return SDL_WaitEventTimeout(event, -1);
+}
+
+int SDL_WaitEventTimeout (SDL_Event *event, int timeout)
+{
+	Uint32 start, elapsed;
+
+	start = SDL_GetTicks();
 	while ( 1 ) {
 		SDL_PumpEvents();
 		switch(SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS)) {
 		    case -1: return 0;
 		    case 1: return 1;
-		    case 0: SDL_Delay(10);
+		    case 0: break;
+		}
+		if ( timeout < 0 ) {
+			SDL_WaitForEvents(-1);
+		} else {
+			elapsed = SDL_GetTicks() - start;
+			if ( elapsed >= (Uint32)timeout ) {
+				return 0;
+			}
+			SDL_WaitForEvents(timeout - (int)elapsed);
 		}
 	}
 }
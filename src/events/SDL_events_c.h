@@ -38,12 +38,14 @@ extern int  SDL_AppActiveInit(void);
 extern int  SDL_KeyboardInit(void);
 extern int  SDL_MouseInit(void);
 extern int  SDL_QuitInit(void);
+extern int  SDL_RecordInit(void);
 
 /* Event handler quit routines */
 extern void SDL_AppActiveQuit(void);
 extern void SDL_KeyboardQuit(void);
 extern void SDL_MouseQuit(void);
 extern void SDL_QuitQuit(void);
+extern void SDL_RecordQuit(void);
 
 /* The event filter function */
 extern SDL_EventFilter SDL_EventOK;
@@ -58,6 +60,7 @@ extern int SDL_PrivateAppActive(Uint8 gain, Uint8 state);
 extern int SDL_PrivateMouseMotion(Uint8 buttonstate, int relative,
 						Sint16 x, Sint16 y);
 extern int SDL_PrivateMouseButton(Uint8 state, Uint8 button,Sint16 x,Sint16 y);
+extern int SDL_PrivateMouseReplay(const SDL_MouseMotionEvent *motion);
 extern int SDL_PrivateKeyboard(Uint8 state, SDL_keysym *key);
 extern int SDL_PrivateResize(int w, int h);
 extern int SDL_PrivateExpose(void);
@@ -76,6 +79,23 @@ extern void SDL_ResetKeyboard(void);
 /* Used by the event loop to queue pending keyboard repeat events */
 extern void SDL_CheckKeyRepeat(void);
 
+/* Used by the event loop to queue the quit event for SIGINT or SIGTERM */
+extern void SDL_CheckQuit(void);
+
+/* Milliseconds until SDL_CheckKeyRepeat() is due, or -1 if no key repeats */
+extern int SDL_KeyRepeatTimeout(void);
+
+/* Event recording and replay (from SDL_record.c) */
+extern int SDL_event_recording;
+extern int SDL_event_replaying;
+#ifdef SDL_HAS_64BIT_TYPE
+extern void SDL_RecordEvent(const SDL_Event *event, Uint64 time);
+#endif
+extern void SDL_CheckReplay(void);
+
+/* Milliseconds until SDL_CheckReplay() is due, or -1 if not replaying */
+extern int SDL_ReplayTimeout(void);
+
 /* Used by the OS keyboard code to detect whether or not to do UNICODE */
 #ifndef DEFAULT_UNICODE_TRANSLATION
 #define DEFAULT_UNICODE_TRANSLATION 0	/* Default off because of overhead */
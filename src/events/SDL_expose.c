@@ -31,11 +31,9 @@
 int SDL_PrivateExpose(void)
 {
 	int posted;
-	SDL_Event events[32];
 
 	/* Pull out all old refresh events */
-	SDL_PeepEvents(events, sizeof(events)/sizeof(events[0]),
-	                    SDL_GETEVENT, SDL_VIDEOEXPOSEMASK);
+	SDL_DrainEvents(NULL, 0, SDL_VIDEOEXPOSEMASK);
 
 	/* Post the event, if desired */
 	posted = 0;
@@ -606,6 +606,25 @@ void SDL_CheckKeyRepeat(void)
 	}
 }
 
+int SDL_KeyRepeatTimeout(void)
+{
+	Uint32 interval, elapsed;
+
+	if ( ! SDL_KeyRepeat.timestamp ) {
+		return(-1);
+	}
+	if ( SDL_KeyRepeat.firsttime ) {
+		interval = SDL_KeyRepeat.delay;
+	} else {
+		interval = SDL_KeyRepeat.interval;
+	}
+	elapsed = SDL_GetTicks() - SDL_KeyRepeat.timestamp;
+	if ( elapsed > interval ) {
+		return(0);
+	}
+	return((int)(interval - elapsed) + 1);
+}
+
 int SDL_EnableKeyRepeat(int delay, int interval)
 {
 	if ( (delay < 0) || (interval < 0) ) {
@@ -194,6 +194,35 @@ printf("Mouse event didn't change state - dropped!\n");
 	return(posted);
 }
 
+/* Post a recorded motion event as it was, since the relative motion can't
+   be worked out again from the position when the mouse is grabbed */
+int SDL_PrivateMouseReplay(const SDL_MouseMotionEvent *motion)
+{
+	int posted;
+
+	/* Update internal mouse state */
+	SDL_ButtonState = motion->state;
+	SDL_MouseX = (Sint16)motion->x;
+	SDL_MouseY = (Sint16)motion->y;
+	SDL_DeltaX += motion->xrel;
+	SDL_DeltaY += motion->yrel;
+	SDL_MoveCursor(SDL_MouseX, SDL_MouseY);
+
+	/* Post the event, if desired */
+	posted = 0;
+	if ( SDL_ProcessEvents[SDL_MOUSEMOTION] == SDL_ENABLE ) {
+		SDL_Event event;
+		SDL_memset(&event, 0, sizeof(event));
+		event.motion = *motion;
+		event.type = SDL_MOUSEMOTION;
+		if ( (SDL_EventOK == NULL) || (*SDL_EventOK)(&event) ) {
+			posted = 1;
+			SDL_PushEvent(&event);
+		}
+	}
+	return(posted);
+}
+
 int SDL_PrivateMouseButton(Uint8 state, Uint8 button, Sint16 x, Sint16 y)
 {
 	SDL_Event event;
@@ -29,19 +29,39 @@
 
 #include "SDL_events.h"
 #include "SDL_events_c.h"
+#include "../video/SDL_sysvideo.h"
 
 
 #ifdef HAVE_SIGNAL_H
+/* Adding an event isn't safe in a signal handler, since it allocates
+   memory and takes locks, so the event loop does it for the handler */
+static volatile sig_atomic_t SDL_quit_signaled = 0;
+
 static void SDL_HandleSIG(int sig)
 {
 	/* Reset the signal handler */
 	signal(sig, SDL_HandleSIG);
 
 	/* Signal a quit interrupt */
-	SDL_PrivateQuit();
+	SDL_quit_signaled = 1;
+
+	/* Let SDL_WaitEvent() see it */
+	if ( current_video && current_video->WakeEvents ) {
+		current_video->WakeEvents(current_video);
+	}
 }
 #endif /* HAVE_SIGNAL_H */
 
+void SDL_CheckQuit(void)
+{
+#ifdef HAVE_SIGNAL_H
+	if ( SDL_quit_signaled ) {
+		SDL_quit_signaled = 0;
+		SDL_PrivateQuit();
+	}
+#endif
+}
+
 /* Public functions */
 int SDL_QuitInit(void)
 {
@@ -76,6 +96,9 @@ int SDL_QuitInit(void)
 	if ( ohandler != SIG_DFL )
 		signal(SIGTERM, ohandler);
 #endif /* HAVE_SIGNAL_H */
+#ifdef HAVE_SIGNAL_H
+	SDL_quit_signaled = 0;
+#endif
 
 	/* That's it! */
 	return(0);
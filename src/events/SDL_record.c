@@ -0,0 +1,581 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Event recording and replay for SDL
+
+   A recording starts with the four bytes "SDLR" and a little-endian 32-bit
+   version number.  Each event follows as a record of:
+	64-bit time in microseconds since recording started
+	8-bit event type
+	8-bit length of the data that follows
+	the event data, with multibyte values little-endian
+   Pointers in user events aren't recorded, and window manager events
+   aren't recorded at all.
+ */
+
+#include "SDL_events.h"
+#include "SDL_timer.h"
+#include "SDL_thread.h"
+#include "SDL_events_c.h"
+
+#define RECORD_MAGIC	"SDLR"
+#define RECORD_VERSION	1
+#define RECORD_HEADER	10	/* Time, type and length */
+
+/* Public data -- checked by the event queue before calling us */
+int SDL_event_recording = 0;
+int SDL_event_replaying = 0;
+
+#ifdef SDL_HAS_64BIT_TYPE
+
+static struct {
+	SDL_mutex *lock;
+	SDL_RWops *dst;
+	Uint32 mask;
+	Uint64 start;
+} SDL_Recorder;
+
+static struct {
+	SDL_RWops *src;
+	double speed;
+	Uint64 start;
+	int have_next;		/* 'next' was read and not injected yet */
+	Uint64 next_time;
+	SDL_Event next;
+} SDL_Player;
+
+/* Convert performance counter ticks to microseconds without overflowing */
+static Uint64 SDL_TicksToMicro(Uint64 ticks)
+{
+	Uint64 freq = SDL_GetPerformanceFrequency();
+
+	return (ticks / freq) * 1000000 + ((ticks % freq) * 1000000) / freq;
+}
+
+static Uint8 *SDL_Put16(Uint8 *p, Uint16 value)
+{
+	p[0] = (Uint8)value;
+	p[1] = (Uint8)(value >> 8);
+	return(p+2);
+}
+
+static Uint8 *SDL_Put32(Uint8 *p, Uint32 value)
+{
+	p = SDL_Put16(p, (Uint16)value);
+	return(SDL_Put16(p, (Uint16)(value >> 16)));
+}
+
+static Uint16 SDL_Get16(const Uint8 *p)
+{
+	return (Uint16)(p[0] | (p[1] << 8));
+}
+
+static Uint32 SDL_Get32(const Uint8 *p)
+{
+	return (Uint32)SDL_Get16(p) | ((Uint32)SDL_Get16(p+2) << 16);
+}
+
+/* Store the data of an event, returning its length, or -1 if it isn't
+   recorded */
+static int SDL_PackEvent(const SDL_Event *event, Uint8 *data)
+{
+	Uint8 *p = data;
+
+	switch (event->type) {
+	    case SDL_ACTIVEEVENT:
+		*p++ = event->active.gain;
+		*p++ = event->active.state;
+		break;
+	    case SDL_KEYDOWN:
+	    case SDL_KEYUP:
+		*p++ = event->key.which;
+		*p++ = event->key.state;
+		*p++ = event->key.keysym.scancode;
+		p = SDL_Put32(p, (Uint32)event->key.keysym.sym);
+		p = SDL_Put32(p, (Uint32)event->key.keysym.mod);
+		p = SDL_Put16(p, event->key.keysym.unicode);
+		break;
+	    case SDL_MOUSEMOTION:
+		*p++ = event->motion.which;
+		*p++ = event->motion.state;
+		p = SDL_Put16(p, event->motion.x);
+		p = SDL_Put16(p, event->motion.y);
+		p = SDL_Put16(p, (Uint16)event->motion.xrel);
+		p = SDL_Put16(p, (Uint16)event->motion.yrel);
+		break;
+	    case SDL_MOUSEBUTTONDOWN:
+	    case SDL_MOUSEBUTTONUP:
+		*p++ = event->button.which;
+		*p++ = event->button.button;
+		*p++ = event->button.state;
+		p = SDL_Put16(p, event->button.x);
+		p = SDL_Put16(p, event->button.y);
+		break;
+	    case SDL_JOYAXISMOTION:
+		*p++ = event->jaxis.which;
+		*p++ = event->jaxis.axis;
+		p = SDL_Put16(p, (Uint16)event->jaxis.value);
+		break;
+	    case SDL_JOYBALLMOTION:
+		*p++ = event->jball.which;
+		*p++ = event->jball.ball;
+		p = SDL_Put16(p, (Uint16)event->jball.xrel);
+		p = SDL_Put16(p, (Uint16)event->jball.yrel);
+		break;
+	    case SDL_JOYHATMOTION:
+		*p++ = event->jhat.which;
+		*p++ = event->jhat.hat;
+		*p++ = event->jhat.value;
+		break;
+	    case SDL_JOYBUTTONDOWN:
+	    case SDL_JOYBUTTONUP:
+		*p++ = event->jbutton.which;
+		*p++ = event->jbutton.button;
+		*p++ = event->jbutton.state;
+		break;
+	    case SDL_VIDEORESIZE:
+		p = SDL_Put32(p, (Uint32)event->resize.w);
+		p = SDL_Put32(p, (Uint32)event->resize.h);
+		break;
+	    case SDL_QUIT:
+	    case SDL_VIDEOEXPOSE:
+		break;
+	    case SDL_SYSWMEVENT:
+		return(-1);
+	    default:
+		if ( event->type < SDL_USEREVENT ) {
+			return(-1);
+		}
+		p = SDL_Put32(p, (Uint32)event->user.code);
+		break;
+	}
+	return (int)(p - data);
+}
+
+/* Fill in an event from its recorded data, returning 0, or -1 if the data
+   doesn't make sense */
+static int SDL_UnpackEvent(Uint8 type, const Uint8 *p, int len,
+							SDL_Event *event)
+{
+	int expected;
+
+	SDL_memset(event, 0, sizeof(*event));
+	event->type = type;
+	switch (type) {
+	    case SDL_ACTIVEEVENT:
+		expected = 2;
+		if ( len == expected ) {
+			event->active.gain = p[0];
+			event->active.state = p[1];
+		}
+		break;
+	    case SDL_KEYDOWN:
+	    case SDL_KEYUP:
+		expected = 13;
+		if ( len == expected ) {
+			event->key.which = p[0];
+			event->key.state = p[1];
+			event->key.keysym.scancode = p[2];
+			event->key.keysym.sym = (SDLKey)SDL_Get32(p+3);
+			event->key.keysym.mod = (SDLMod)SDL_Get32(p+7);
+			event->key.keysym.unicode = SDL_Get16(p+11);
+		}
+		break;
+	    case SDL_MOUSEMOTION:
+		expected = 10;
+		if ( len == expected ) {
+			event->motion.which = p[0];
+			event->motion.state = p[1];
+			event->motion.x = SDL_Get16(p+2);
+			event->motion.y = SDL_Get16(p+4);
+			event->motion.xrel = (Sint16)SDL_Get16(p+6);
+			event->motion.yrel = (Sint16)SDL_Get16(p+8);
+		}
+		break;
+	    case SDL_MOUSEBUTTONDOWN:
+	    case SDL_MOUSEBUTTONUP:
+		expected = 7;
+		if ( len == expected ) {
+			event->button.which = p[0];
+			event->button.button = p[1];
+			event->button.state = p[2];
+			event->button.x = SDL_Get16(p+3);
+			event->button.y = SDL_Get16(p+5);
+		}
+		break;
+	    case SDL_JOYAXISMOTION:
+		expected = 4;
+		if ( len == expected ) {
+			event->jaxis.which = p[0];
+			event->jaxis.axis = p[1];
+			event->jaxis.value = (Sint16)SDL_Get16(p+2);
+		}
+		break;
+	    case SDL_JOYBALLMOTION:
+		expected = 6;
+		if ( len == expected ) {
+			event->jball.which = p[0];
+			event->jball.ball = p[1];
+			event->jball.xrel = (Sint16)SDL_Get16(p+2);
+			event->jball.yrel = (Sint16)SDL_Get16(p+4);
+		}
+		break;
+	    case SDL_JOYHATMOTION:
+		expected = 3;
+		if ( len == expected ) {
+			event->jhat.which = p[0];
+			event->jhat.hat = p[1];
+			event->jhat.value = p[2];
+		}
+		break;
+	    case SDL_JOYBUTTONDOWN:
+	    case SDL_JOYBUTTONUP:
+		expected = 3;
+		if ( len == expected ) {
+			event->jbutton.which = p[0];
+			event->jbutton.button = p[1];
+			event->jbutton.state = p[2];
+		}
+		break;
+	    case SDL_VIDEORESIZE:
+		expected = 8;
+		if ( len == expected ) {
+			event->resize.w = (int)SDL_Get32(p);
+			event->resize.h = (int)SDL_Get32(p+4);
+		}
+		break;
+	    case SDL_QUIT:
+	    case SDL_VIDEOEXPOSE:
+		expected = 0;
+		break;
+	    default:
+		expected = -1;
+		if ( (type >= SDL_USEREVENT) && (type < SDL_NUMEVENTS) ) {
+			expected = 4;
+			if ( len == expected ) {
+				event->user.code = (int)SDL_Get32(p);
+			}
+		}
+		break;
+	}
+	return (len == expected) ? 0 : -1;
+}
+
+/* This is called by the event queue for each event added to it */
+void SDL_RecordEvent(const SDL_Event *event, Uint64 time)
+{
+	Uint8 record[RECORD_HEADER+255];
+	Uint64 micro;
+	int len;
+
+	if ( !(SDL_Recorder.mask & SDL_EVENTMASK(event->type)) ) {
+		return;
+	}
+	len = SDL_PackEvent(event, &record[RECORD_HEADER]);
+	if ( len < 0 ) {
+		return;
+	}
+
+	SDL_mutexP(SDL_Recorder.lock);
+	if ( SDL_Recorder.dst ) {
+		/* Events may be added with a time before we started */
+		micro = 0;
+		if ( time > SDL_Recorder.start ) {
+			micro = SDL_TicksToMicro(time - SDL_Recorder.start);
+		}
+		SDL_Put32(&record[0], (Uint32)micro);
+		SDL_Put32(&record[4], (Uint32)(micro >> 32));
+		record[8] = event->type;
+		record[9] = (Uint8)len;
+		if ( SDL_RWwrite(SDL_Recorder.dst, record, RECORD_HEADER+len, 1) != 1 ) {
+			/* Keep the error, but don't write partial records */
+			SDL_Recorder.dst = NULL;
+			SDL_event_recording = 0;
+		}
+	}
+	SDL_mutexV(SDL_Recorder.lock);
+}
+
+int SDL_RecordEvents(SDL_RWops *dst, Uint32 mask)
+{
+	Uint8 header[8];
+
+	if ( ! SDL_Recorder.lock ) {
+		SDL_SetError("Event loop is not running");
+		return(-1);
+	}
+	SDL_mutexP(SDL_Recorder.lock);
+	SDL_event_recording = 0;
+	SDL_Recorder.dst = NULL;
+	if ( dst ) {
+		SDL_memcpy(header, RECORD_MAGIC, 4);
+		SDL_Put32(&header[4], RECORD_VERSION);
+		if ( SDL_RWwrite(dst, header, sizeof(header), 1) != 1 ) {
+			SDL_mutexV(SDL_Recorder.lock);
+			return(-1);
+		}
+		SDL_Recorder.dst = dst;
+		SDL_Recorder.mask = mask;
+		SDL_Recorder.start = SDL_GetPerformanceCounter();
+		SDL_event_recording = 1;
+	}
+	SDL_mutexV(SDL_Recorder.lock);
+	return(0);
+}
+
+/* Read the next event to replay, returning 0, or -1 at the end of the
+   recording */
+static int SDL_ReadRecord(void)
+{
+	Uint8 record[RECORD_HEADER+255];
+	int len;
+
+	for ( ; ; ) {
+		if ( SDL_RWread(SDL_Player.src, record, RECORD_HEADER, 1) != 1 ) {
+			return(-1);
+		}
+		len = record[9];
+		if ( len && (SDL_RWread(SDL_Player.src, &record[RECORD_HEADER], len, 1) != 1) ) {
+			return(-1);
+		}
+		/* Skip event types we don't know about */
+		if ( SDL_UnpackEvent(record[8], &record[RECORD_HEADER], len,
+						&SDL_Player.next) == 0 ) {
+			break;
+		}
+	}
+	SDL_Player.next_time = (Uint64)SDL_Get32(&record[0]) |
+	                       ((Uint64)SDL_Get32(&record[4]) << 32);
+	SDL_Player.have_next = 1;
+	return(0);
+}
+
+/* Send a replayed event through the same code as the video driver, so the
+   keyboard and mouse state follow it */
+static void SDL_InjectEvent(SDL_Event *event)
+{
+	switch (event->type) {
+	    case SDL_ACTIVEEVENT:
+		SDL_PrivateAppActive(event->active.gain, event->active.state);
+		break;
+	    case SDL_KEYDOWN:
+	    case SDL_KEYUP:
+		SDL_PrivateKeyboard(event->key.state, &event->key.keysym);
+		break;
+	    case SDL_MOUSEMOTION:
+		SDL_PrivateMouseReplay(&event->motion);
+		break;
+	    case SDL_MOUSEBUTTONDOWN:
+	    case SDL_MOUSEBUTTONUP:
+		SDL_PrivateMouseButton(event->button.state, event->button.button,
+		                       event->button.x, event->button.y);
+		break;
+	    case SDL_VIDEORESIZE:
+		SDL_PrivateResize(event->resize.w, event->resize.h);
+		break;
+	    case SDL_VIDEOEXPOSE:
+		SDL_PrivateExpose();
+		break;
+	    case SDL_QUIT:
+		SDL_PrivateQuit();
+		break;
+	    default:
+		/* Joystick and user events go straight to the queue */
+		SDL_PushEvent(event);
+		break;
+	}
+}
+
+static void SDL_StopReplay(void)
+{
+	SDL_event_replaying = 0;
+	SDL_Player.src = NULL;
+	SDL_Player.have_next = 0;
+}
+
+/* Microseconds of the recording that have been replayed by now */
+static Uint64 SDL_ReplayPosition(void)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	return (Uint64)((double)SDL_TicksToMicro(now - SDL_Player.start) *
+	                SDL_Player.speed);
+}
+
+/* This is called when events are pumped, to inject the events due */
+void SDL_CheckReplay(void)
+{
+	SDL_EventQueueStats stats;
+	Uint64 position;
+
+	SDL_mutexP(SDL_Recorder.lock);
+	position = 0;
+	if ( SDL_Player.src && (SDL_Player.speed > 0.0) ) {
+		position = SDL_ReplayPosition();
+	}
+	while ( SDL_Player.src ) {
+		if ( !SDL_Player.have_next && (SDL_ReadRecord() < 0) ) {
+			SDL_StopReplay();
+			break;
+		}
+		if ( (SDL_Player.speed > 0.0) &&
+		     (SDL_Player.next_time > position) ) {
+			break;
+		}
+		/* Leave the rest until the application makes room for them */
+		SDL_GetEventQueueStats(&stats);
+		if ( stats.queued >= stats.capacity ) {
+			break;
+		}
+		SDL_Player.have_next = 0;
+		SDL_InjectEvent(&SDL_Player.next);
+	}
+	SDL_mutexV(SDL_Recorder.lock);
+}
+
+/* Milliseconds until SDL_CheckReplay() has an event to inject, or -1 if
+   no events are being replayed */
+int SDL_ReplayTimeout(void)
+{
+	Uint64 position;
+	int timeout;
+
+	SDL_mutexP(SDL_Recorder.lock);
+	timeout = -1;
+	if ( SDL_Player.src ) {
+		timeout = 0;
+		if ( SDL_Player.have_next && (SDL_Player.speed > 0.0) ) {
+			position = SDL_ReplayPosition();
+			if ( SDL_Player.next_time > position ) {
+				timeout = (int)((double)(SDL_Player.next_time - position) /
+				                (SDL_Player.speed * 1000.0)) + 1;
+			}
+		}
+	}
+	SDL_mutexV(SDL_Recorder.lock);
+	return(timeout);
+}
+
+int SDL_ReplayEvents(SDL_RWops *src, double speed)
+{
+	Uint8 header[8];
+	int retval;
+
+	if ( ! SDL_Recorder.lock ) {
+		SDL_SetError("Event loop is not running");
+		return(-1);
+	}
+	SDL_mutexP(SDL_Recorder.lock);
+	SDL_StopReplay();
+	retval = 0;
+	if ( src ) {
+		if ( SDL_RWread(src, header, sizeof(header), 1) != 1 ||
+		     SDL_memcmp(header, RECORD_MAGIC, 4) != 0 ) {
+			SDL_SetError("Not an SDL event recording");
+			retval = -1;
+		} else if ( SDL_Get32(&header[4]) != RECORD_VERSION ) {
+			SDL_SetError("Unsupported event recording version %d",
+			             (int)SDL_Get32(&header[4]));
+			retval = -1;
+		} else {
+			SDL_Player.src = src;
+			SDL_Player.speed = speed;
+			SDL_Player.start = SDL_GetPerformanceCounter();
+			SDL_event_replaying = 1;
+		}
+	}
+	SDL_mutexV(SDL_Recorder.lock);
+	return(retval);
+}
+
+int SDL_ReplayingEvents(void)
+{
+	return(SDL_event_replaying);
+}
+
+int SDL_RecordInit(void)
+{
+	SDL_Recorder.lock = SDL_CreateMutex();
+	if ( ! SDL_Recorder.lock ) {
+		return(-1);
+	}
+	return(0);
+}
+
+void SDL_RecordQuit(void)
+{
+	SDL_event_recording = 0;
+	SDL_Recorder.dst = NULL;
+	SDL_StopReplay();
+	if ( SDL_Recorder.lock ) {
+		SDL_DestroyMutex(SDL_Recorder.lock);
+		SDL_Recorder.lock = NULL;
+	}
+}
+
+#else
+
+/* Recordings need the 64-bit performance counter */
+
+void SDL_CheckReplay(void)
+{
+}
+
+int SDL_ReplayTimeout(void)
+{
+	return(-1);
+}
+
+int SDL_RecordEvents(SDL_RWops *dst, Uint32 mask)
+{
+	if ( dst ) {
+		SDL_SetError("Event recording is not supported");
+		return(-1);
+	}
+	return(0);
+}
+
+int SDL_ReplayEvents(SDL_RWops *src, double speed)
+{
+	if ( src ) {
+		SDL_SetError("Event replay is not supported");
+		return(-1);
+	}
+	return(0);
+}
+
+int SDL_ReplayingEvents(void)
+{
+	return(0);
+}
+
+int SDL_RecordInit(void)
+{
+	return(0);
+}
+
+void SDL_RecordQuit(void)
+{
+}
+
+#endif /* SDL_HAS_64BIT_TYPE */
@@ -38,7 +38,6 @@ static struct {
 int SDL_PrivateResize(int w, int h)
 {
 	int posted;
-	SDL_Event events[32];
 
 	/* See if this event would change the video surface */
 	if ( !w || !h ||
@@ -52,8 +51,7 @@ int SDL_PrivateResize(int w, int h)
 	SDL_SetMouseRange(w, h);
 
 	/* Pull out all old resize events */
-	SDL_PeepEvents(events, sizeof(events)/sizeof(events[0]),
-	                    SDL_GETEVENT, SDL_VIDEORESIZEMASK);
+	SDL_DrainEvents(NULL, 0, SDL_VIDEORESIZEMASK);
 
 	/* Post the event, if desired */
 	posted = 0;
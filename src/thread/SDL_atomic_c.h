@@ -0,0 +1,80 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+#ifndef _SDL_atomic_c_h
+#define _SDL_atomic_c_h
+
+/* The few atomic operations SDL uses internally for lock-free structures.
+   All of them are full memory barriers.  SDL_HAS_ATOMICS is 0 when the
+   compiler doesn't provide them, and callers must fall back to a mutex.
+ */
+
+#if SDL_THREADS_DISABLED
+#define SDL_HAS_ATOMICS	0
+#elif defined(__GNUC__) && \
+      ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#define SDL_HAS_ATOMICS	1
+
+/* Add 'value' to '*p', returning the old value */
+static __inline__ int SDL_AtomicAdd(volatile int *p, int value)
+{
+	return __sync_fetch_and_add(p, value);
+}
+
+/* Set '*p' to 'newval' if it is 'oldval', returning true if it was */
+static __inline__ int SDL_AtomicCAS(volatile int *p, int oldval, int newval)
+{
+	return __sync_bool_compare_and_swap(p, oldval, newval);
+}
+
+static __inline__ int SDL_AtomicCASPtr(void * volatile *p, void *oldval, void *newval)
+{
+	return __sync_bool_compare_and_swap(p, oldval, newval);
+}
+
+#elif defined(__WIN32__) && !defined(_WIN32_WCE)
+#define SDL_HAS_ATOMICS	1
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+static __inline__ int SDL_AtomicAdd(volatile int *p, int value)
+{
+	return (int)InterlockedExchangeAdd((LONG volatile *)p, value);
+}
+
+static __inline__ int SDL_AtomicCAS(volatile int *p, int oldval, int newval)
+{
+	return (InterlockedCompareExchange((LONG volatile *)p, newval, oldval) == oldval);
+}
+
+static __inline__ int SDL_AtomicCASPtr(void * volatile *p, void *oldval, void *newval)
+{
+	return (InterlockedCompareExchangePointer(p, newval, oldval) == oldval);
+}
+
+#else
+#define SDL_HAS_ATOMICS	0
+#endif
+
+#endif /* _SDL_atomic_c_h */
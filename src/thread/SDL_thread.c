@@ -298,3 +298,67 @@ void SDL_KillThread(SDL_Thread *thread)
 	}
 }
 
+
+/* Arguments for one slice of SDL_ParallelFor() */
+typedef struct {
+	void (*func)(void *, int);
+	void *data;
+	int index;
+} parallel_args;
+
+static int SDLCALL SDL_RunParallel(void *data)
+{
+	parallel_args *args = (parallel_args *)data;
+
+	args->func(args->data, args->index);
+	return(0);
+}
+
+void SDL_ParallelFor(int count, void (*func)(void *data, int index), void *data)
+{
+	parallel_args *args;
+	SDL_Thread **threads;
+	int i;
+
+	args = NULL;
+	threads = NULL;
+	if ( count > 1 ) {
+		args = (parallel_args *)SDL_malloc(count*(sizeof *args));
+		threads = (SDL_Thread **)SDL_malloc(count*(sizeof *threads));
+	}
+	if ( (args == NULL) || (threads == NULL) ) {
+		/* Not worth a thread, or no memory for one: run serially */
+		if ( args ) {
+			SDL_free(args);
+		}
+		if ( threads ) {
+			SDL_free(threads);
+		}
+		for ( i=0; i<count; ++i ) {
+			func(data, i);
+		}
+		return;
+	}
+
+	/* The calling thread takes the first slice itself */
+	for ( i=1; i<count; ++i ) {
+		args[i].func = func;
+		args[i].data = data;
+		args[i].index = i;
+#ifdef SDL_PASSED_BEGINTHREAD_ENDTHREAD
+		threads[i] = SDL_CreateThread(SDL_RunParallel, &args[i], NULL, NULL);
+#else
+		threads[i] = SDL_CreateThread(SDL_RunParallel, &args[i]);
+#endif
+	}
+	func(data, 0);
+	for ( i=1; i<count; ++i ) {
+		if ( threads[i] ) {
+			SDL_WaitThread(threads[i], NULL);
+		} else {
+			func(data, i);
+		}
+	}
+	SDL_free(threads);
+	SDL_free(args);
+}
@@ -61,4 +61,10 @@ struct SDL_Thread {
 /* This is the function called to run a thread */
 extern void SDL_RunThread(void *data);
 
+/* Call func(data, index) for each index in [0, count), spreading the calls
+   across worker threads.  The calls are made on the calling thread if no
+   threads can be created, and all of them have finished on return.
+ */
+extern void SDL_ParallelFor(int count, void (*func)(void *data, int index), void *data);
+
 #endif /* _SDL_thread_c_h */
@@ -38,3 +38,21 @@ extern int SDL_SYS_StartTimer(void);
 
 /* Stop a previously started timer */
 extern void SDL_SYS_StopTimer(void);
+
+#if SDL_TIMER_UNIX && HAVE_TIMERFD && defined(SDL_HAS_64BIT_TYPE) && !SDL_THREADS_DISABLED
+#define SDL_SYS_TIMERWAIT	1
+
+/* Sleep until SDL_GetPerformanceCounter() reaches '*deadline', or forever
+   if 'deadline' is NULL, returning early if SDL_SYS_TimerWake() is called.
+   This returns -1 without sleeping if the system can't wait this way.
+ */
+extern int SDL_SYS_TimerWait(const Uint64 *deadline);
+extern void SDL_SYS_TimerWake(void);
+#endif
+
+#if SDL_TIMER_UNIX && HAVE_NANOSLEEP && !SDL_THREAD_PTH
+#define SDL_SYS_DELAYMICRO	1
+
+/* Wait at least 'us' microseconds before returning */
+extern void SDL_SYS_DelayMicro(Uint32 us);
+#endif
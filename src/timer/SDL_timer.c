@@ -24,7 +24,9 @@
 #include "SDL_timer.h"
 #include "SDL_timer_c.h"
 #include "SDL_mutex.h"
+#include "SDL_thread.h"
 #include "SDL_systimer.h"
+#include "../thread/SDL_atomic_c.h"
 
 /* #define DEBUG_TIMERS */
 
@@ -35,20 +37,138 @@ int SDL_timer_running = 0;
 Uint32 SDL_alarm_interval = 0;
 SDL_TimerCallback SDL_alarm_callback;
 
-/* Data used for a thread-based timer */
+/* Data used for a thread-based timer
+
+   Timers are kept in a binary heap ordered by deadline, so the next timer
+   due is always at the top, and each timer knows its place in the heap so
+   it can be removed without searching.  Timers are recycled instead of
+   being freed until the timer subsystem is shut down, so removing a timer
+   that has already expired is safe.
+
+   Deadlines are kept in performance counter ticks, and are advanced by
+   whole periods so periodic timers don't drift when they run late.
+
+   A timer is taken out of the heap while its callback runs, so it can't
+   run again until the callback returns.  Callbacks run on the thread that
+   checks the timers, or on a pool of worker threads if SDL_TIMER_THREADS
+   is set, so one slow callback doesn't hold up the others.
+ */
 static int SDL_timer_threaded = 0;
 
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Uint64 SDL_TimerTime;
+typedef Sint64 SDL_TimerDiff;
+#define SDL_TimerNow()	SDL_GetPerformanceCounter()
+#define SDL_TimerFreq()	SDL_GetPerformanceFrequency()
+#else
+typedef Uint32 SDL_TimerTime;
+typedef Sint32 SDL_TimerDiff;
+#define SDL_TimerNow()	SDL_GetTicks()
+#define SDL_TimerFreq()	1000
+#endif
+
 struct _SDL_TimerID {
-	Uint32 interval;
+	Uint32 interval;	/* Milliseconds, or microseconds if precise */
 	SDL_NewTimerCallback cb;
+	SDL_PreciseTimerCallback precise_cb;
 	void *param;
-	Uint32 last_alarm;
-	struct _SDL_TimerID *next;
+	SDL_TimerTime period;	/* The interval in timer ticks */
+	SDL_TimerTime deadline;
+	int index;			/* Place in the heap, or -1 */
+	int busy;			/* The callback is queued or running */
+	int removed;			/* Removed while busy */
+	int generation;			/* SDL_timer_generation when it ran */
+	SDL_TimerTime due;		/* Deadline the callback is running for */
+	Uint32 skipped;			/* Deadlines missed before this one */
+	struct _SDL_TimerID *next;	/* Next free or queued timer */
+
+	/* Statistics, in timer ticks */
+	Uint32 calls;
+	Uint32 overruns;
+	SDL_TimerTime latency_total;
+	SDL_TimerTime latency_max;
+	SDL_TimerTime duration_total;
+	SDL_TimerTime duration_max;
 };
 
-static SDL_TimerID SDL_timers = NULL;
+static SDL_TimerID *SDL_timer_heap = NULL;
+static int SDL_timer_heapsize = 0;
+static int SDL_timer_heapmax = 0;
+static SDL_TimerID SDL_timer_free = NULL;
+static int SDL_timer_generation = 0;	/* Changed when all timers are removed */
 static SDL_mutex *SDL_timer_mutex;
-static volatile SDL_bool list_changed = SDL_FALSE;
+static SDL_cond *SDL_timer_cond;
+static int SDL_timer_wakeup = 0;
+
+/* The worker threads and the timers queued for them */
+#define MAX_TIMER_THREADS	32
+static SDL_Thread *SDL_timer_workers[MAX_TIMER_THREADS];
+static int SDL_timer_numworkers = 0;
+static int SDL_timer_workers_alive = 0;
+static SDL_cond *SDL_timer_work_cond;
+static SDL_TimerID SDL_timer_queue = NULL;
+static SDL_TimerID SDL_timer_queue_tail = NULL;
+
+static int SDLCALL SDL_TimerWorker(void *unused);
+
+#define TIMER_BEFORE(a, b)	((SDL_TimerDiff)((a)->deadline - (b)->deadline) < 0)
+
+#ifdef SDL_HAS_64BIT_TYPE
+#if !SDL_TIMER_UNIX
+/* Extend SDL_GetTicks() to 64 bits by counting the times it wraps.
+   This only works if it is called at least once every 24 days.
+
+   Another thread may have read the ticks a little earlier and not got
+   here yet, so ticks behind the last ones seen are taken as old rather
+   than as a wrap.  The count is kept under a spin lock where atomic
+   operations are available, so two threads can't both count a wrap.
+ */
+#if SDL_HAS_ATOMICS
+static volatile int SDL_ticks_lock = 0;
+#define LOCK_TICKS()	while ( !SDL_AtomicCAS(&SDL_ticks_lock, 0, 1) ) { }
+#define UNLOCK_TICKS()	SDL_AtomicCAS(&SDL_ticks_lock, 1, 0)
+#else
+#define LOCK_TICKS()
+#define UNLOCK_TICKS()
+#endif
+
+Uint64 SDL_GetTicks64(void)
+{
+	static Uint32 last_ticks = 0;
+	static Uint32 wraps = 0;
+	Uint32 ticks, epoch;
+
+	ticks = SDL_GetTicks();
+	LOCK_TICKS();
+	if ( (Sint32)(ticks - last_ticks) >= 0 ) {
+		if ( ticks < last_ticks ) {
+			++wraps;
+		}
+		last_ticks = ticks;
+		epoch = wraps;
+	} else if ( ticks > last_ticks && wraps ) {
+		epoch = wraps - 1;	/* Read before the last wrap */
+	} else {
+		epoch = wraps;
+	}
+	UNLOCK_TICKS();
+	return(((Uint64)epoch << 32) | ticks);
+}
+#endif /* !SDL_TIMER_UNIX */
+
+#if !SDL_TIMER_UNIX && !SDL_TIMER_WIN32
+/* Platforms without a better clock count milliseconds */
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	return(SDL_GetTicks64());
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return(1000);
+}
+#endif
+#endif /* SDL_HAS_64BIT_TYPE */
 
 /* Set whether or not the timer should use a thread.
    This should not be called while the timer subsystem is running.
@@ -67,6 +187,72 @@ int SDL_SetTimerThreaded(int value)
 	return retval;
 }
 
+/* Start the worker threads asked for by SDL_TIMER_THREADS */
+static void SDL_StartTimerWorkers(void)
+{
+	const char *env;
+	int i, count;
+
+	count = 0;
+	env = SDL_getenv("SDL_TIMER_THREADS");
+	if ( env ) {
+		count = SDL_atoi(env);
+	}
+	if ( count <= 0 ) {
+		return;
+	}
+	if ( count > MAX_TIMER_THREADS ) {
+		count = MAX_TIMER_THREADS;
+	}
+	SDL_timer_work_cond = SDL_CreateCond();
+	if ( ! SDL_timer_work_cond ) {
+		return;
+	}
+	SDL_timer_workers_alive = 1;
+	for ( i = 0; i < count; ++i ) {
+		SDL_timer_workers[i] = SDL_CreateThread(SDL_TimerWorker, NULL);
+		if ( SDL_timer_workers[i] == NULL ) {
+			break;
+		}
+	}
+	SDL_timer_numworkers = i;
+	if ( SDL_timer_numworkers == 0 ) {
+		/* Run the callbacks on the timer thread after all */
+		SDL_timer_workers_alive = 0;
+		SDL_DestroyCond(SDL_timer_work_cond);
+		SDL_timer_work_cond = NULL;
+	}
+}
+
+static void SDL_StopTimerWorkers(void)
+{
+	SDL_TimerID t;
+	int i;
+
+	if ( SDL_timer_numworkers == 0 ) {
+		return;
+	}
+	SDL_mutexP(SDL_timer_mutex);
+	SDL_timer_workers_alive = 0;
+	SDL_CondBroadcast(SDL_timer_work_cond);
+	SDL_mutexV(SDL_timer_mutex);
+	for ( i = 0; i < SDL_timer_numworkers; ++i ) {
+		SDL_WaitThread(SDL_timer_workers[i], NULL);
+		SDL_timer_workers[i] = NULL;
+	}
+	SDL_timer_numworkers = 0;
+	SDL_DestroyCond(SDL_timer_work_cond);
+	SDL_timer_work_cond = NULL;
+
+	/* The timers still queued were removed by SDL_SetTimer(0, NULL) */
+	while ( SDL_timer_queue ) {
+		t = SDL_timer_queue;
+		SDL_timer_queue = t->next;
+		SDL_free(t);
+	}
+	SDL_timer_queue_tail = NULL;
+}
+
 int SDL_TimerInit(void)
 {
 	int retval;
@@ -80,6 +266,10 @@ int SDL_TimerInit(void)
 	}
 	if ( SDL_timer_threaded ) {
 		SDL_timer_mutex = SDL_CreateMutex();
+		SDL_timer_cond = SDL_CreateCond();
+	}
+	if ( SDL_timer_mutex ) {
+		SDL_StartTimerWorkers();
 	}
 	if ( retval == 0 ) {
 		SDL_timer_started = 1;
@@ -89,92 +279,359 @@ int SDL_TimerInit(void)
 
 void SDL_TimerQuit(void)
 {
+	SDL_TimerID t;
+
 	SDL_SetTimer(0, NULL);
 	if ( SDL_timer_threaded < 2 ) {
 		SDL_SYS_TimerQuit();
 	}
+	SDL_StopTimerWorkers();
 	if ( SDL_timer_threaded ) {
+		SDL_DestroyCond(SDL_timer_cond);
+		SDL_timer_cond = NULL;
 		SDL_DestroyMutex(SDL_timer_mutex);
 		SDL_timer_mutex = NULL;
 	}
+	while ( SDL_timer_free ) {
+		t = SDL_timer_free;
+		SDL_timer_free = t->next;
+		SDL_free(t);
+	}
+	if ( SDL_timer_heap ) {
+		SDL_free(SDL_timer_heap);
+		SDL_timer_heap = NULL;
+	}
+	SDL_timer_heapmax = 0;
 	SDL_timer_started = 0;
 	SDL_timer_threaded = 0;
 }
 
-void SDL_ThreadedTimerCheck(void)
+/* Convert an interval in 1/'units' seconds to timer ticks, rounding up */
+static SDL_TimerTime SDL_TimerPeriod(Uint32 interval, Uint32 units)
 {
-	Uint32 now, ms;
-	SDL_TimerID t, prev, next;
-	SDL_bool removed;
+	SDL_TimerTime period;
+
+#ifdef SDL_HAS_64BIT_TYPE
+	period = ((Uint64)interval * SDL_TimerFreq() + units - 1) / units;
+#else
+	period = (interval / units) * 1000 +
+	         ((interval % units) * 1000 + units - 1) / units;
+#endif
+	return period ? period : 1;
+}
 
+/* Move a timer up the heap until its parent is due before it */
+static void SDL_SiftUp(int i)
+{
+	SDL_TimerID t = SDL_timer_heap[i];
+	int parent;
+
+	while ( i > 0 ) {
+		parent = (i - 1) / 2;
+		if ( ! TIMER_BEFORE(t, SDL_timer_heap[parent]) ) {
+			break;
+		}
+		SDL_timer_heap[i] = SDL_timer_heap[parent];
+		SDL_timer_heap[i]->index = i;
+		i = parent;
+	}
+	SDL_timer_heap[i] = t;
+	t->index = i;
+}
+
+/* Move a timer down the heap until its children are due after it */
+static void SDL_SiftDown(int i)
+{
+	SDL_TimerID t = SDL_timer_heap[i];
+	int child;
+
+	while ( (child = 2 * i + 1) < SDL_timer_heapsize ) {
+		if ( (child + 1 < SDL_timer_heapsize) &&
+		     TIMER_BEFORE(SDL_timer_heap[child+1], SDL_timer_heap[child]) ) {
+			++child;
+		}
+		if ( ! TIMER_BEFORE(SDL_timer_heap[child], t) ) {
+			break;
+		}
+		SDL_timer_heap[i] = SDL_timer_heap[child];
+		SDL_timer_heap[i]->index = i;
+		i = child;
+	}
+	SDL_timer_heap[i] = t;
+	t->index = i;
+}
+
+/* Make room in the heap for 'count' timers, so reinserting a timer after
+   its callback runs can't fail */
+static int SDL_HeapReserve(int count)
+{
+	SDL_TimerID *heap;
+	int heapmax;
+
+	if ( count > SDL_timer_heapmax ) {
+		heapmax = SDL_timer_heapmax ? SDL_timer_heapmax * 2 : 16;
+		while ( heapmax < count ) {
+			heapmax *= 2;
+		}
+		heap = (SDL_TimerID *)SDL_realloc(SDL_timer_heap,
+		                                  heapmax * sizeof(*heap));
+		if ( heap == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		SDL_timer_heap = heap;
+		SDL_timer_heapmax = heapmax;
+	}
+	return(0);
+}
+
+static void SDL_HeapInsert(SDL_TimerID t)
+{
+	SDL_timer_heap[SDL_timer_heapsize] = t;
+	SDL_SiftUp(SDL_timer_heapsize++);
+}
+
+static void SDL_HeapRemove(SDL_TimerID t)
+{
+	int i = t->index;
+
+	t->index = -1;
+	if ( i == --SDL_timer_heapsize ) {
+		return;
+	}
+	/* Fill the hole with the last timer and restore the heap order */
+	SDL_timer_heap[i] = SDL_timer_heap[SDL_timer_heapsize];
+	SDL_timer_heap[i]->index = i;
+	if ( (i > 0) && TIMER_BEFORE(SDL_timer_heap[i], SDL_timer_heap[(i-1)/2]) ) {
+		SDL_SiftUp(i);
+	} else {
+		SDL_SiftDown(i);
+	}
+}
+
+static void SDL_FreeTimer(SDL_TimerID t)
+{
+	t->index = -1;
+	t->busy = 0;
+	t->next = SDL_timer_free;
+	SDL_timer_free = t;
+}
+
+/* Run the callback of a timer taken from the heap and put it back, with
+   the timer mutex held */
+static void SDL_RunTimer(SDL_TimerID t)
+{
+	SDL_TimerTime start, end, period;
+	Uint32 ms, interval;
+
+	if ( t->removed || (t->generation != SDL_timer_generation) ) {
+		/* The timer was removed while it waited for a worker */
+		SDL_FreeTimer(t);
+		return;
+	}
+	interval = t->interval;
+	SDL_mutexV(SDL_timer_mutex);
+	start = SDL_TimerNow();
+	if ( t->precise_cb ) {
+		ms = t->precise_cb(interval, t->skipped, t->param);
+	} else {
+		ms = t->cb(interval, t->param);
+	}
+	end = SDL_TimerNow();
 	SDL_mutexP(SDL_timer_mutex);
-	list_changed = SDL_FALSE;
-	now = SDL_GetTicks();
-	for ( prev = NULL, t = SDL_timers; t; t = next ) {
-		removed = SDL_FALSE;
-		ms = t->interval - SDL_TIMESLICE;
-		next = t->next;
-		if ( (int)(now - t->last_alarm) > (int)ms ) {
-			struct _SDL_TimerID timer;
-
-			if ( (now - t->last_alarm) < t->interval ) {
-				t->last_alarm += t->interval;
-			} else {
-				t->last_alarm = now;
-			}
+	if ( t->removed || (t->generation != SDL_timer_generation) ) {
+		/* The timer was removed while its callback ran */
+		SDL_FreeTimer(t);
+		return;
+	}
+	t->busy = 0;
+
+	++t->calls;
+	t->overruns += t->skipped;
+	if ( (SDL_TimerDiff)(start - t->due) > 0 ) {
+		t->latency_total += start - t->due;
+		if ( start - t->due > t->latency_max ) {
+			t->latency_max = start - t->due;
+		}
+	}
+	t->duration_total += end - start;
+	if ( end - start > t->duration_max ) {
+		t->duration_max = end - start;
+	}
+
+	if ( ! ms ) {
 #ifdef DEBUG_TIMERS
-			printf("Executing timer %p (thread = %d)\n",
-				t, SDL_ThreadID());
+		printf("SDL: Removing timer %p\n", t);
 #endif
-			timer = *t;
-			SDL_mutexV(SDL_timer_mutex);
-			ms = timer.cb(timer.interval, timer.param);
-			SDL_mutexP(SDL_timer_mutex);
-			if ( list_changed ) {
-				/* Abort, list of timers modified */
-				/* FIXME: what if ms was changed? */
-				break;
-			}
-			if ( ms != t->interval ) {
-				if ( ms ) {
-					t->interval = ROUND_RESOLUTION(ms);
-				} else {
-					/* Remove timer from the list */
+		SDL_FreeTimer(t);
+		--SDL_timer_running;
+		return;
+	}
+	if ( ms != interval ) {
+		period = SDL_TimerPeriod(ms, t->precise_cb ? 1000000 : 1000);
+		t->deadline += period - t->period;
+		t->interval = ms;
+		t->period = period;
+	}
+	SDL_HeapInsert(t);
+	if ( (t->index == 0) && SDL_timer_numworkers ) {
+		/* The timer thread may be sleeping past the new deadline */
+		SDL_ThreadedTimerWake();
+	}
+}
+
+static int SDLCALL SDL_TimerWorker(void *unused)
+{
+	SDL_TimerID t;
+
+	SDL_mutexP(SDL_timer_mutex);
+	while ( SDL_timer_workers_alive ) {
+		t = SDL_timer_queue;
+		if ( ! t ) {
+			SDL_CondWait(SDL_timer_work_cond, SDL_timer_mutex);
+			continue;
+		}
+		SDL_timer_queue = t->next;
+		if ( ! SDL_timer_queue ) {
+			SDL_timer_queue_tail = NULL;
+		}
+		SDL_RunTimer(t);
+	}
+	SDL_mutexV(SDL_timer_mutex);
+	return(0);
+}
+
+void SDL_ThreadedTimerCheck(void)
+{
+	SDL_TimerTime now;
+	SDL_TimerID t;
+
+	SDL_mutexP(SDL_timer_mutex);
+	now = SDL_TimerNow();
+	while ( SDL_timer_heapsize > 0 ) {
+		t = SDL_timer_heap[0];
+		if ( (SDL_TimerDiff)(t->deadline - now) > 0 ) {
+			break;
+		}
+		SDL_HeapRemove(t);
+
+		/* Skip the periods that were missed, keeping the timer's phase.
+		   The new deadline is after 'now', so each timer runs at most
+		   once per check.
+		 */
+		t->due = t->deadline;
+		t->skipped = (Uint32)((now - t->deadline) / t->period);
+		t->deadline += (SDL_TimerTime)(t->skipped + 1) * t->period;
+		t->busy = 1;
+		t->removed = 0;
+		t->generation = SDL_timer_generation;
 #ifdef DEBUG_TIMERS
-					printf("SDL: Removing timer %p\n", t);
+		printf("Executing timer %p (thread = %d)\n",
+			t, SDL_ThreadID());
 #endif
-					if ( prev ) {
-						prev->next = next;
-					} else {
-						SDL_timers = next;
-					}
-					SDL_free(t);
-					--SDL_timer_running;
-					removed = SDL_TRUE;
-				}
+		if ( SDL_timer_numworkers ) {
+			t->next = NULL;
+			if ( SDL_timer_queue_tail ) {
+				SDL_timer_queue_tail->next = t;
+			} else {
+				SDL_timer_queue = t;
 			}
+			SDL_timer_queue_tail = t;
+			SDL_CondSignal(SDL_timer_work_cond);
+		} else {
+			SDL_RunTimer(t);
 		}
-		/* Don't update prev if the timer has disappeared */
-		if ( ! removed ) {
-			prev = t;
+	}
+	SDL_mutexV(SDL_timer_mutex);
+}
+
+/* Sleep until the next timer is due or SDL_ThreadedTimerWake() is called */
+void SDL_ThreadedTimerWait(void)
+{
+	SDL_TimerDiff ticks;
+	Uint32 ms;
+
+	if ( ! SDL_timer_cond ) {
+		SDL_Delay(1);
+		return;
+	}
+	SDL_mutexP(SDL_timer_mutex);
+#if SDL_SYS_TIMERWAIT
+	/* The system can sleep until the exact deadline */
+	{
+		Uint64 deadline = 0;
+		int have_deadline = (SDL_timer_heapsize > 0);
+
+		if ( have_deadline ) {
+			deadline = SDL_timer_heap[0]->deadline;
 		}
+		SDL_mutexV(SDL_timer_mutex);
+		if ( SDL_SYS_TimerWait(have_deadline ? &deadline : NULL) == 0 ) {
+			return;
+		}
+		SDL_mutexP(SDL_timer_mutex);
 	}
+#endif
+	if ( ! SDL_timer_wakeup ) {
+		if ( SDL_timer_heapsize == 0 ) {
+			SDL_CondWait(SDL_timer_cond, SDL_timer_mutex);
+		} else {
+			ticks = (SDL_TimerDiff)(SDL_timer_heap[0]->deadline - SDL_TimerNow());
+			if ( ticks > 0 ) {
+				/* Round up, so we don't wake up just before it */
+				ms = (Uint32)((ticks * 1000 + SDL_TimerFreq() - 1) / SDL_TimerFreq());
+				SDL_CondWaitTimeout(SDL_timer_cond, SDL_timer_mutex, ms);
+			}
+		}
+	}
+	SDL_timer_wakeup = 0;
 	SDL_mutexV(SDL_timer_mutex);
 }
 
-static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+void SDL_ThreadedTimerWake(void)
+{
+	if ( SDL_timer_cond ) {
+		SDL_mutexP(SDL_timer_mutex);
+		SDL_timer_wakeup = 1;
+		SDL_CondSignal(SDL_timer_cond);
+#if SDL_SYS_TIMERWAIT
+		SDL_SYS_TimerWake();
+#endif
+		SDL_mutexV(SDL_timer_mutex);
+	}
+}
+
+static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback callback, SDL_PreciseTimerCallback precise_callback, void *param)
 {
 	SDL_TimerID t;
-	t = (SDL_TimerID) SDL_malloc(sizeof(struct _SDL_TimerID));
+
+	/* Every running timer has to fit in the heap at once */
+	if ( SDL_HeapReserve(SDL_timer_running + 1) < 0 ) {
+		return NULL;
+	}
+	t = SDL_timer_free;
+	if ( t ) {
+		SDL_timer_free = t->next;
+	} else {
+		t = (SDL_TimerID) SDL_malloc(sizeof(struct _SDL_TimerID));
+		if ( t == NULL ) {
+			SDL_OutOfMemory();
+		}
+	}
 	if ( t ) {
-		t->interval = ROUND_RESOLUTION(interval);
+		SDL_memset(t, 0, sizeof(*t));
+		t->interval = interval;
 		t->cb = callback;
+		t->precise_cb = precise_callback;
 		t->param = param;
-		t->last_alarm = SDL_GetTicks();
-		t->next = SDL_timers;
-		SDL_timers = t;
+		t->period = SDL_TimerPeriod(interval, precise_callback ? 1000000 : 1000);
+		t->deadline = SDL_TimerNow() + t->period;
+		SDL_HeapInsert(t);
 		++SDL_timer_running;
-		list_changed = SDL_TRUE;
+		/* The timer thread may have to wake up earlier now */
+		if ( t->index == 0 ) {
+			SDL_ThreadedTimerWake();
+		}
 	}
 #ifdef DEBUG_TIMERS
 	printf("SDL_AddTimer(%d) = %08x num_timers = %d\n", interval, (Uint32)t, SDL_timer_running);
@@ -182,7 +639,7 @@ static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback ca
 	return t;
 }
 
-SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+static SDL_TimerID SDL_AddThreadedTimer(Uint32 interval, SDL_NewTimerCallback callback, SDL_PreciseTimerCallback precise_callback, void *param)
 {
 	SDL_TimerID t;
 	if ( ! SDL_timer_mutex ) {
@@ -198,32 +655,48 @@ SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *p
 		return NULL;
 	}
 	SDL_mutexP(SDL_timer_mutex);
-	t = SDL_AddTimerInternal(interval, callback, param);
+	t = SDL_AddTimerInternal(interval, callback, precise_callback, param);
 	SDL_mutexV(SDL_timer_mutex);
 	return t;
 }
 
+SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *param)
+{
+	return SDL_AddThreadedTimer(interval, callback, NULL, param);
+}
+
+SDL_TimerID SDL_AddPreciseTimer(Uint32 interval, SDL_PreciseTimerCallback callback, void *param)
+{
+	return SDL_AddThreadedTimer(interval, NULL, callback, param);
+}
+
+static SDL_bool SDL_TimerInHeap(SDL_TimerID id)
+{
+	return (id->index >= 0) && (id->index < SDL_timer_heapsize) &&
+	       (SDL_timer_heap[id->index] == id);
+}
+
 SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 {
-	SDL_TimerID t, prev = NULL;
 	SDL_bool removed;
 
 	removed = SDL_FALSE;
+	if ( ! id || ! SDL_timer_mutex ) {
+		return removed;
+	}
 	SDL_mutexP(SDL_timer_mutex);
-	/* Look for id in the linked list of timers */
-	for (t = SDL_timers; t; prev=t, t = t->next ) {
-		if ( t == id ) {
-			if(prev) {
-				prev->next = t->next;
-			} else {
-				SDL_timers = t->next;
-			}
-			SDL_free(t);
+	if ( id->busy ) {
+		/* It's freed when the callback returns */
+		if ( ! id->removed && (id->generation == SDL_timer_generation) ) {
+			id->removed = 1;
 			--SDL_timer_running;
 			removed = SDL_TRUE;
-			list_changed = SDL_TRUE;
-			break;
 		}
+	} else if ( SDL_TimerInHeap(id) ) {
+		SDL_HeapRemove(id);
+		SDL_FreeTimer(id);
+		--SDL_timer_running;
+		removed = SDL_TRUE;
 	}
 #ifdef DEBUG_TIMERS
 	printf("SDL_RemoveTimer(%08x) = %d num_timers = %d thread = %d\n", (Uint32)id, removed, SDL_timer_running, SDL_ThreadID());
@@ -232,6 +705,47 @@ SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 	return removed;
 }
 
+/* Convert timer ticks to microseconds, without overflowing */
+static Uint32 SDL_TimerMicro(SDL_TimerTime ticks)
+{
+	SDL_TimerTime micro;
+
+	micro = (ticks / SDL_TimerFreq()) * 1000000 +
+	        ((ticks % SDL_TimerFreq()) * 1000000) / SDL_TimerFreq();
+	return (micro > 0xFFFFFFFF) ? 0xFFFFFFFF : (Uint32)micro;
+}
+
+int SDL_GetTimerStats(SDL_TimerID id, SDL_TimerStats *stats)
+{
+	int retval;
+
+	if ( ! id || ! SDL_timer_mutex ) {
+		SDL_SetError("Invalid timer");
+		return(-1);
+	}
+	SDL_mutexP(SDL_timer_mutex);
+	retval = 0;
+	if ( SDL_TimerInHeap(id) ||
+	     (id->busy && !id->removed &&
+	      (id->generation == SDL_timer_generation)) ) {
+		stats->calls = id->calls;
+		stats->overruns = id->overruns;
+		stats->latency_avg = 0;
+		stats->duration_avg = 0;
+		if ( id->calls ) {
+			stats->latency_avg = SDL_TimerMicro(id->latency_total / id->calls);
+			stats->duration_avg = SDL_TimerMicro(id->duration_total / id->calls);
+		}
+		stats->latency_max = SDL_TimerMicro(id->latency_max);
+		stats->duration_max = SDL_TimerMicro(id->duration_max);
+	} else {
+		SDL_SetError("Invalid timer");
+		retval = -1;
+	}
+	SDL_mutexV(SDL_timer_mutex);
+	return(retval);
+}
+
 /* Old style callback functions are wrapped through this */
 static Uint32 SDLCALL callback_wrapper(Uint32 ms, void *param)
 {
@@ -253,13 +767,13 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 	}
 	if ( SDL_timer_running ) {	/* Stop any currently running timer */
 		if ( SDL_timer_threaded ) {
-			while ( SDL_timers ) {
-				SDL_TimerID freeme = SDL_timers;
-				SDL_timers = SDL_timers->next;
-				SDL_free(freeme);
+			while ( SDL_timer_heapsize > 0 ) {
+				SDL_TimerID freeme = SDL_timer_heap[--SDL_timer_heapsize];
+				SDL_FreeTimer(freeme);
 			}
+			/* Timers that are busy are freed when they're done */
+			++SDL_timer_generation;
 			SDL_timer_running = 0;
-			list_changed = SDL_TRUE;
 		} else {
 			SDL_SYS_StopTimer();
 			SDL_timer_running = 0;
@@ -267,7 +781,7 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 	}
 	if ( ms ) {
 		if ( SDL_timer_threaded ) {
-			if ( SDL_AddTimerInternal(ms, callback_wrapper, (void *)callback) == NULL ) {
+			if ( SDL_AddTimerInternal(ms, callback_wrapper, NULL, (void *)callback) == NULL ) {
 				retval = -1;
 			}
 		} else {
@@ -283,3 +797,158 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 
 	return retval;
 }
+
+/* Sleeping wakes up late by an amount that depends on the system and its
+   load, so SDL_DelayUntil() sleeps until this many microseconds before the
+   deadline and waits on the counter for the rest.  It's adjusted after
+   every sleep, and a race between threads updating it is harmless.
+ */
+#define MIN_DELAY_MARGIN	200
+#if SDL_SYS_DELAYMICRO
+#define MAX_DELAY_MARGIN	4000
+#else
+#define MAX_DELAY_MARGIN	16000
+#endif
+static Uint32 SDL_delay_margin = 1000;
+
+static void SDL_DelayUntil(SDL_TimerTime deadline)
+{
+	SDL_TimerTime now, wake;
+	Uint32 us, late, margin, target;
+
+	now = SDL_TimerNow();
+	if ( (SDL_TimerDiff)(deadline - now) <= 0 ) {
+		return;
+	}
+	us = SDL_TimerMicro(deadline - now);
+	margin = SDL_delay_margin;
+	if ( us > margin ) {
+		us -= margin;
+#if SDL_SYS_DELAYMICRO
+		SDL_SYS_DelayMicro(us);
+#else
+		us -= us % 1000;
+		SDL_Delay(us / 1000);
+#endif
+		wake = now + SDL_TimerPeriod(us, 1000000);
+		now = SDL_TimerNow();
+		late = 0;
+		if ( (SDL_TimerDiff)(now - wake) > 0 ) {
+			late = SDL_TimerMicro(now - wake);
+		}
+
+		/* Leave twice the latest oversleep, backing off slowly */
+		target = (late > MAX_DELAY_MARGIN/2) ? MAX_DELAY_MARGIN : late * 2;
+		if ( target < MIN_DELAY_MARGIN ) {
+			target = MIN_DELAY_MARGIN;
+		}
+		if ( late > margin ) {
+			margin = target;
+		} else if ( target < margin ) {
+			margin -= (margin - target) / 16;
+		}
+		SDL_delay_margin = margin;
+	}
+	while ( (SDL_TimerDiff)(deadline - SDL_TimerNow()) > 0 ) {
+		/* Wait on the counter for the rest of the time */
+	}
+}
+
+void SDL_DelayPrecise(Uint32 us)
+{
+	if ( us ) {
+		SDL_DelayUntil(SDL_TimerNow() + SDL_TimerPeriod(us, 1000000));
+	}
+}
+
+struct _SDL_FrameLimiter {
+	SDL_TimerTime period;
+	SDL_TimerTime deadline;		/* When the next frame is due */
+	SDL_TimerTime last;		/* When the last frame started */
+
+	/* Statistics, in timer ticks */
+	Uint32 frames;
+	Uint32 missed;
+	SDL_TimerTime frame_total;
+	SDL_TimerTime jitter_total;
+	SDL_TimerTime jitter_max;
+};
+
+SDL_FrameLimiter *SDL_CreateFrameLimiter(double rate)
+{
+	SDL_FrameLimiter *limiter;
+	SDL_TimerTime period;
+
+	if ( !(rate > 0.0) ) {
+		SDL_SetError("Invalid frame rate");
+		return(NULL);
+	}
+	period = (SDL_TimerTime)((double)SDL_TimerFreq() / rate + 0.5);
+	if ( ! period ) {
+		period = 1;
+	}
+	limiter = (SDL_FrameLimiter *)SDL_malloc(sizeof(*limiter));
+	if ( ! limiter ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(limiter, 0, sizeof(*limiter));
+	limiter->period = period;
+	limiter->last = SDL_TimerNow();
+	limiter->deadline = limiter->last + period;
+	return(limiter);
+}
+
+void SDL_FrameLimiterWait(SDL_FrameLimiter *limiter)
+{
+	SDL_TimerTime now, jitter;
+
+	now = SDL_TimerNow();
+	if ( (SDL_TimerDiff)(limiter->deadline - now) > 0 ) {
+		SDL_DelayUntil(limiter->deadline);
+		now = SDL_TimerNow();
+	} else {
+		++limiter->missed;
+	}
+	jitter = now - limiter->deadline;
+	limiter->jitter_total += jitter;
+	if ( jitter > limiter->jitter_max ) {
+		limiter->jitter_max = jitter;
+	}
+	limiter->frame_total += now - limiter->last;
+	++limiter->frames;
+	limiter->last = now;
+
+	/* Start over if we've fallen more than a frame behind */
+	limiter->deadline += limiter->period;
+	if ( (SDL_TimerDiff)(now - limiter->deadline) >= 0 ) {
+		limiter->deadline = now + limiter->period;
+	}
+}
+
+void SDL_GetFrameStats(SDL_FrameLimiter *limiter, SDL_FrameStats *stats)
+{
+	stats->frames = limiter->frames;
+	stats->missed = limiter->missed;
+	stats->frame_avg = 0;
+	stats->jitter_avg = 0;
+	if ( limiter->frames ) {
+		stats->frame_avg = SDL_TimerMicro(limiter->frame_total / limiter->frames);
+		stats->jitter_avg = SDL_TimerMicro(limiter->jitter_total / limiter->frames);
+	}
+	stats->jitter_max = SDL_TimerMicro(limiter->jitter_max);
+}
+
+void SDL_ResetFrameStats(SDL_FrameLimiter *limiter)
+{
+	limiter->frames = 0;
+	limiter->missed = 0;
+	limiter->frame_total = 0;
+	limiter->jitter_total = 0;
+	limiter->jitter_max = 0;
+}
+
+void SDL_FreeFrameLimiter(SDL_FrameLimiter *limiter)
+{
+	SDL_free(limiter);
+}
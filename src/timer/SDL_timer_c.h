@@ -44,3 +44,9 @@ extern void SDL_TimerQuit(void);
 
 /* This function is called from the SDL event thread if it is available */
 extern void SDL_ThreadedTimerCheck(void);
+
+/* A timer thread of its own sleeps in SDL_ThreadedTimerWait() until the
+   next timer is due, and is woken early by SDL_ThreadedTimerWake()
+ */
+extern void SDL_ThreadedTimerWait(void);
+extern void SDL_ThreadedTimerWake(void);
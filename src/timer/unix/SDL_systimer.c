@@ -32,6 +32,7 @@
 
 #include "SDL_timer.h"
 #include "../SDL_timer_c.h"
+#include "../SDL_systimer.h"
 
 /* The clock_gettime provides monotonous time, so we should use it if
    it's available. The clock_gettime function is behind ifdef
@@ -85,6 +86,43 @@ Uint32 SDL_GetTicks (void)
 #endif
 }
 
+#ifdef SDL_HAS_64BIT_TYPE
+Uint64 SDL_GetTicks64 (void)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return(((Uint64)(now.tv_sec-start.tv_sec)*1000000000+now.tv_nsec-start.tv_nsec)/1000000);
+#else
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return(((Uint64)(now.tv_sec-start.tv_sec)*1000000+now.tv_usec-start.tv_usec)/1000);
+#endif
+}
+
+Uint64 SDL_GetPerformanceCounter (void)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return((Uint64)now.tv_sec*1000000000+now.tv_nsec);
+#else
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return((Uint64)now.tv_sec*1000000+now.tv_usec);
+#endif
+}
+
+Uint64 SDL_GetPerformanceFrequency (void)
+{
+#if HAVE_CLOCK_GETTIME
+	return(1000000000);
+#else
+	return(1000000);
+#endif
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_Delay (Uint32 ms)
 {
 #if SDL_THREAD_PTH
@@ -134,6 +172,23 @@ void SDL_Delay (Uint32 ms)
 #endif /* SDL_THREAD_PTH */
 }
 
+#if SDL_SYS_DELAYMICRO
+void SDL_SYS_DelayMicro(Uint32 us)
+{
+	struct timespec elapsed, tv;
+	int was_error;
+
+	elapsed.tv_sec = us/1000000;
+	elapsed.tv_nsec = (us%1000000)*1000;
+	do {
+		errno = 0;
+		tv.tv_sec = elapsed.tv_sec;
+		tv.tv_nsec = elapsed.tv_nsec;
+		was_error = nanosleep(&tv, &elapsed);
+	} while ( was_error && (errno == EINTR) );
+}
+#endif /* SDL_SYS_DELAYMICRO */
+
 #ifdef USE_ITIMER
 
 static void HandleAlarm(int sig)
@@ -194,13 +249,105 @@ void SDL_SYS_StopTimer(void)
 static int timer_alive = 0;
 static SDL_Thread *timer = NULL;
 
+#if SDL_SYS_TIMERWAIT
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/timerfd.h>
+
+/* The timer thread sleeps on a timerfd set to the next deadline, which
+   has nanosecond resolution, and is woken early through a pipe.
+ */
+static int timer_fd = -1;
+static int wake_pipe[2] = { -1, -1 };
+
+static void OpenTimerWait(void)
+{
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
+	if ( timer_fd < 0 ) {
+		return;
+	}
+	if ( pipe(wake_pipe) < 0 ) {
+		close(timer_fd);
+		timer_fd = -1;
+		return;
+	}
+	fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+}
+
+static void CloseTimerWait(void)
+{
+	if ( timer_fd >= 0 ) {
+		close(timer_fd);
+		close(wake_pipe[0]);
+		close(wake_pipe[1]);
+		timer_fd = -1;
+		wake_pipe[0] = -1;
+		wake_pipe[1] = -1;
+	}
+}
+
+int SDL_SYS_TimerWait(const Uint64 *deadline)
+{
+	struct itimerspec when;
+	fd_set fdset;
+	Uint64 expirations;
+	char buf[32];
+	int maxfd;
+
+	if ( timer_fd < 0 ) {
+		return(-1);
+	}
+
+	/* The performance counter is CLOCK_MONOTONIC in nanoseconds */
+	SDL_memset(&when, 0, sizeof(when));
+	if ( deadline ) {
+		when.it_value.tv_sec = (time_t)(*deadline / 1000000000);
+		when.it_value.tv_nsec = (long)(*deadline % 1000000000);
+		if ( !when.it_value.tv_sec && !when.it_value.tv_nsec ) {
+			/* Zero would disarm the timer */
+			when.it_value.tv_nsec = 1;
+		}
+	}
+	timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &when, NULL);
+
+	FD_ZERO(&fdset);
+	FD_SET(timer_fd, &fdset);
+	FD_SET(wake_pipe[0], &fdset);
+	maxfd = (timer_fd > wake_pipe[0]) ? timer_fd : wake_pipe[0];
+	if ( select(maxfd+1, &fdset, NULL, NULL, NULL) > 0 ) {
+		if ( FD_ISSET(timer_fd, &fdset) ) {
+			if ( read(timer_fd, &expirations, sizeof(expirations)) < 0 ) {
+				/* The timer was already read */
+			}
+		}
+		if ( FD_ISSET(wake_pipe[0], &fdset) ) {
+			while ( read(wake_pipe[0], buf, sizeof(buf)) > 0 ) {
+				/* Empty the pipe */
+			}
+		}
+	}
+	return(0);
+}
+
+void SDL_SYS_TimerWake(void)
+{
+	if ( wake_pipe[1] >= 0 ) {
+		/* If the pipe is full, a wakeup is already pending */
+		if ( write(wake_pipe[1], "", 1) < 0 ) {
+			return;
+		}
+	}
+}
+#endif /* SDL_SYS_TIMERWAIT */
+
 static int RunTimer(void *unused)
 {
 	while ( timer_alive ) {
 		if ( SDL_timer_running ) {
 			SDL_ThreadedTimerCheck();
 		}
-		SDL_Delay(1);
+		SDL_ThreadedTimerWait();
 	}
 	return(0);
 }
@@ -209,6 +356,9 @@ static int RunTimer(void *unused)
 int SDL_SYS_TimerInit(void)
 {
 	timer_alive = 1;
+#if SDL_SYS_TIMERWAIT
+	OpenTimerWait();
+#endif
 	timer = SDL_CreateThread(RunTimer, NULL);
 	if ( timer == NULL )
 		return(-1);
@@ -218,10 +368,14 @@ int SDL_SYS_TimerInit(void)
 void SDL_SYS_TimerQuit(void)
 {
 	timer_alive = 0;
+	SDL_ThreadedTimerWake();
 	if ( timer ) {
 		SDL_WaitThread(timer, NULL);
 		timer = NULL;
 	}
+#if SDL_SYS_TIMERWAIT
+	CloseTimerWait();
+#endif
 }
 
 int SDL_SYS_StartTimer(void)
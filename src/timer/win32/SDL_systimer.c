@@ -104,6 +104,28 @@ Uint32 SDL_GetTicks(void)
 	return(ticks);
 }
 
+#ifdef SDL_HAS_64BIT_TYPE
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	LARGE_INTEGER counter;
+
+	if ( !QueryPerformanceCounter(&counter) ) {
+		return(SDL_GetTicks64());
+	}
+	return((Uint64)counter.QuadPart);
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	LARGE_INTEGER frequency;
+
+	if ( !QueryPerformanceFrequency(&frequency) ) {
+		return(1000);
+	}
+	return((Uint64)frequency.QuadPart);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_Delay(Uint32 ms)
 {
 	Sleep(ms);
@@ -87,9 +87,13 @@
  */
 
 #include "SDL_video.h"
+#include "SDL_endian.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
+#include "SDL_pixels_c.h"
 #include "SDL_RLEaccel_c.h"
+#include "SDL_cpuinfo.h"
+#include "../thread/SDL_thread_c.h"
 
 /* Force MMX to 0; this blows up on almost every major compiler now. --ryan. */
 #if 0 && defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && SDL_ASSEMBLY_ROUTINES
@@ -98,7 +102,6 @@
 
 #ifdef MMX_ASMBLIT
 #include "mmx.h"
-#include "SDL_cpuinfo.h"
 #endif
 
 #ifndef MAX
@@ -1396,105 +1399,117 @@ static int uncopy_32(Uint32 *dst, void *src, int n,
 #define ISTRANSL(pixel, fmt)	\
     ((unsigned)((((pixel) & fmt->Amask) >> fmt->Ashift) - 1U) < 254U)
 
-/* convert surface to be quickly alpha-blittable onto dest, if possible */
-static int RLEAlphaSurface(SDL_Surface *surface)
-{
-    SDL_Surface *dest;
+/*
+ * Encoding is done in horizontal bands of scan lines, each written to a
+ * buffer of its own. The bands of large surfaces are encoded in parallel
+ * and then concatenated; this works because no scan line depends on the
+ * ones before it, as long as the bands keep their alignment.
+ */
+#define RLE_BAND_PIXELS	(256 * 256)	/* smallest band worth a thread */
+
+typedef struct {
+    int y, h;			/* scan lines in the band */
+    Uint8 *buf;			/* encoded lines */
+    int size;			/* bytes used in buf */
+    int lastline;		/* end of last non-blank line, 0 if none */
+} RLEBand;
+
+typedef struct RLEEncoder {
+    SDL_Surface *surface;
+    void (*encode)(struct RLEEncoder *enc, RLEBand *band);
+    int linesize;		/* worst case size of an encoded scan line */
+    int parallel;		/* bands can be moved around when aligned */
+    RLEBand *bands;
+
+    /* used by the per-pixel alpha encoder only */
     SDL_PixelFormat *df;
-    int maxsize = 0;
     int max_opaque_run;
-    int max_transl_run = 65535;
-    unsigned masksum;
-    Uint8 *rlebuf, *dst;
     int (*copy_opaque)(void *, Uint32 *, int,
 		       SDL_PixelFormat *, SDL_PixelFormat *);
     int (*copy_transl)(void *, Uint32 *, int,
 		       SDL_PixelFormat *, SDL_PixelFormat *);
+} RLEEncoder;
 
-    dest = surface->map->dst;
-    if(!dest)
-	return -1;
-    df = dest->format;
-    if(surface->format->BitsPerPixel != 32)
-	return -1;		/* only 32bpp source supported */
-
-    /* find out whether the destination is one we support,
-       and determine the max size of the encoded result */
-    masksum = df->Rmask | df->Gmask | df->Bmask;
-    switch(df->BytesPerPixel) {
-    case 2:
-	/* 16bpp: only support 565 and 555 formats */
-	switch(masksum) {
-	case 0xffff:
-	    if(df->Gmask == 0x07e0
-	       || df->Rmask == 0x07e0 || df->Bmask == 0x07e0) {
-		copy_opaque = copy_opaque_16;
-		copy_transl = copy_transl_565;
-	    } else
-		return -1;
-	    break;
-	case 0x7fff:
-	    if(df->Gmask == 0x03e0
-	       || df->Rmask == 0x03e0 || df->Bmask == 0x03e0) {
-		copy_opaque = copy_opaque_16;
-		copy_transl = copy_transl_555;
-	    } else
-		return -1;
-	    break;
-	default:
-	    return -1;
-	}
-	max_opaque_run = 255;	/* runs stored as bytes */
+static void RLEEncodeBand(void *data, int index)
+{
+    RLEEncoder *enc = (RLEEncoder *)data;
+    enc->encode(enc, &enc->bands[index]);
+}
 
-	/* worst case is alternating opaque and translucent pixels,
-	   with room for alignment padding between lines */
-	maxsize = surface->h * (2 + (4 + 2) * (surface->w + 1)) + 2;
-	break;
-    case 4:
-	if(masksum != 0x00ffffff)
-	    return -1;		/* requires unused high byte */
-	copy_opaque = copy_32;
-	copy_transl = copy_32;
-	max_opaque_run = 255;	/* runs stored as short ints */
+/*
+ * Encode all scan lines of the surface into dst, which must have room for
+ * the worst case. Returns the end of the last non-blank line, which is
+ * where the end marker goes.
+ */
+static Uint8 *RLEEncodeLines(RLEEncoder *enc, Uint8 *dst)
+{
+    SDL_Surface *surface = enc->surface;
+    RLEBand *bands = NULL;
+    Uint8 *lastline;
+    int numbands = 1;
+    int i;
 
-	/* worst case is alternating opaque and translucent pixels */
-	maxsize = surface->h * 2 * 4 * (surface->w + 1) + 4;
-	break;
-    default:
-	return -1;		/* anything else unsupported right now */
+    if(enc->parallel) {
+	numbands = (surface->w * surface->h) / RLE_BAND_PIXELS;
+	if(numbands > SDL_GetCPUCount())
+	    numbands = SDL_GetCPUCount();
+	if(numbands > surface->h)
+	    numbands = surface->h;
+    }
+    if(numbands > 1) {
+	bands = (RLEBand *)SDL_malloc(numbands * sizeof(*bands));
+	for(i = 0; bands && i < numbands; i++) {
+	    bands[i].y = surface->h * i / numbands;
+	    bands[i].h = surface->h * (i + 1) / numbands - bands[i].y;
+	    bands[i].buf = (Uint8 *)SDL_malloc(bands[i].h * enc->linesize);
+	    if(!bands[i].buf) {
+		/* fall back to encoding in place */
+		while(i--)
+		    SDL_free(bands[i].buf);
+		SDL_free(bands);
+		bands = NULL;
+	    }
+	}
     }
 
-    maxsize += sizeof(RLEDestFormat);
-    rlebuf = (Uint8 *)SDL_malloc(maxsize);
-    if(!rlebuf) {
-	SDL_OutOfMemory();
-	return -1;
+    if(!bands) {
+	RLEBand band;
+	band.y = 0;
+	band.h = surface->h;
+	band.buf = dst;
+	enc->encode(enc, &band);
+	return dst + band.lastline;
     }
-    {
-	/* save the destination format so we can undo the encoding later */
-	RLEDestFormat *r = (RLEDestFormat *)rlebuf;
-	r->BytesPerPixel = df->BytesPerPixel;
-	r->Rloss = df->Rloss;
-	r->Gloss = df->Gloss;
-	r->Bloss = df->Bloss;
-	r->Rshift = df->Rshift;
-	r->Gshift = df->Gshift;
-	r->Bshift = df->Bshift;
-	r->Ashift = df->Ashift;
-	r->Rmask = df->Rmask;
-	r->Gmask = df->Gmask;
-	r->Bmask = df->Bmask;
-	r->Amask = df->Amask;
+
+    enc->bands = bands;
+    SDL_ParallelFor(numbands, RLEEncodeBand, enc);
+    enc->bands = NULL;
+
+    lastline = dst;
+    for(i = 0; i < numbands; i++) {
+	SDL_memcpy(dst, bands[i].buf, bands[i].size);
+	if(bands[i].lastline)
+	    lastline = dst + bands[i].lastline;
+	dst += bands[i].size;
+	SDL_free(bands[i].buf);
     }
-    dst = rlebuf + sizeof(RLEDestFormat);
+    SDL_free(bands);
+    return lastline;
+}
 
-    /* Do the actual encoding */
-    {
-	int x, y;
-	int h = surface->h, w = surface->w;
-	SDL_PixelFormat *sf = surface->format;
-	Uint32 *src = (Uint32 *)surface->pixels;
-	Uint8 *lastline = dst;	/* end of last non-blank line */
+/* encode a band of a surface with per-pixel alpha */
+static void RLEAlphaBand(RLEEncoder *enc, RLEBand *band)
+{
+    int x, y;
+    int w = enc->surface->w;
+    SDL_PixelFormat *sf = enc->surface->format;
+    SDL_PixelFormat *df = enc->df;
+    int max_opaque_run = enc->max_opaque_run;
+    int max_transl_run = 65535;
+    Uint32 *src = (Uint32 *)((Uint8 *)enc->surface->pixels
+			     + band->y * enc->surface->pitch);
+    Uint8 *dst = band->buf;
+    Uint8 *lastline = dst;	/* end of last non-blank line */
 
 	/* opaque counts are 8 or 16 bits, depending on target depth */
 #define ADD_OPAQUE_COUNTS(n, m)			\
@@ -1512,7 +1527,7 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 #define ADD_TRANSL_COUNTS(n, m)		\
 	(((Uint16 *)dst)[0] = n, ((Uint16 *)dst)[1] = m, dst += 4)
 
-	for(y = 0; y < h; y++) {
+	for(y = 0; y < band->h; y++) {
 	    int runstart, skipstart;
 	    int blankline = 0;
 	    /* First encode all opaque pixels of a scan line */
@@ -1535,13 +1550,13 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 		}
 		len = MIN(run, max_opaque_run);
 		ADD_OPAQUE_COUNTS(skip, len);
-		dst += copy_opaque(dst, src + runstart, len, sf, df);
+		dst += enc->copy_opaque(dst, src + runstart, len, sf, df);
 		runstart += len;
 		run -= len;
 		while(run) {
 		    len = MIN(run, max_opaque_run);
 		    ADD_OPAQUE_COUNTS(0, len);
-		    dst += copy_opaque(dst, src + runstart, len, sf, df);
+		    dst += enc->copy_opaque(dst, src + runstart, len, sf, df);
 		    runstart += len;
 		    run -= len;
 		}
@@ -1569,13 +1584,13 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 		}
 		len = MIN(run, max_transl_run);
 		ADD_TRANSL_COUNTS(skip, len);
-		dst += copy_transl(dst, src + runstart, len, sf, df);
+		dst += enc->copy_transl(dst, src + runstart, len, sf, df);
 		runstart += len;
 		run -= len;
 		while(run) {
 		    len = MIN(run, max_transl_run);
 		    ADD_TRANSL_COUNTS(0, len);
-		    dst += copy_transl(dst, src + runstart, len, sf, df);
+		    dst += enc->copy_transl(dst, src + runstart, len, sf, df);
 		    runstart += len;
 		    run -= len;
 		}
@@ -1583,31 +1598,126 @@ static int RLEAlphaSurface(SDL_Surface *surface)
 		    lastline = dst;
 	    } while(x < w);
 
-	    src += surface->pitch >> 2;
+	    src += enc->surface->pitch >> 2;
 	}
-	dst = lastline;		/* back up past trailing blank lines */
-	ADD_OPAQUE_COUNTS(0, 0);
-    }
 
-#undef ADD_OPAQUE_COUNTS
 #undef ADD_TRANSL_COUNTS
 
-    /* Now that we have it encoded, release the original pixels */
-    if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-       && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	SDL_free( surface->pixels );
-	surface->pixels = NULL;
+    band->size = dst - band->buf;
+    band->lastline = lastline - band->buf;
+}
+
+/* convert surface to be quickly alpha-blittable onto dest, if possible */
+static Uint8 *RLEAlphaSurface(SDL_Surface *surface, int *length)
+{
+    SDL_Surface *dest;
+    SDL_PixelFormat *df;
+    int maxsize = 0;
+    unsigned masksum;
+    Uint8 *rlebuf, *dst;
+    RLEEncoder enc;
+
+    dest = surface->map->dst;
+    if(!dest)
+	return NULL;
+    df = dest->format;
+    if(surface->format->BitsPerPixel != 32)
+	return NULL;		/* only 32bpp source supported */
+
+    SDL_memset(&enc, 0, sizeof(enc));
+    enc.surface = surface;
+    enc.encode = RLEAlphaBand;
+    enc.df = df;
+
+    /* find out whether the destination is one we support,
+       and determine the max size of the encoded result */
+    masksum = df->Rmask | df->Gmask | df->Bmask;
+    switch(df->BytesPerPixel) {
+    case 2:
+	/* 16bpp: only support 565 and 555 formats */
+	switch(masksum) {
+	case 0xffff:
+	    if(df->Gmask == 0x07e0
+	       || df->Rmask == 0x07e0 || df->Bmask == 0x07e0) {
+		enc.copy_opaque = copy_opaque_16;
+		enc.copy_transl = copy_transl_565;
+	    } else
+		return NULL;
+	    break;
+	case 0x7fff:
+	    if(df->Gmask == 0x03e0
+	       || df->Rmask == 0x03e0 || df->Bmask == 0x03e0) {
+		enc.copy_opaque = copy_opaque_16;
+		enc.copy_transl = copy_transl_555;
+	    } else
+		return NULL;
+	    break;
+	default:
+	    return NULL;
+	}
+	enc.max_opaque_run = 255;	/* runs stored as bytes */
+
+	/* worst case is alternating opaque and translucent pixels,
+	   with room for alignment padding between lines */
+	enc.linesize = 2 + (4 + 2) * (surface->w + 1);
+	maxsize = surface->h * enc.linesize + 2;
+
+	/* the padding depends on the address, so encode in one piece */
+	enc.parallel = 0;
+	break;
+    case 4:
+	if(masksum != 0x00ffffff)
+	    return NULL;		/* requires unused high byte */
+	enc.copy_opaque = copy_32;
+	enc.copy_transl = copy_32;
+	enc.max_opaque_run = 255;	/* runs stored as short ints */
+
+	/* worst case is alternating opaque and translucent pixels */
+	enc.linesize = 2 * 4 * (surface->w + 1);
+	maxsize = surface->h * enc.linesize + 4;
+	enc.parallel = 1;
+	break;
+    default:
+	return NULL;		/* anything else unsupported right now */
+    }
+
+    maxsize += sizeof(RLEDestFormat);
+    rlebuf = (Uint8 *)SDL_malloc(maxsize);
+    if(!rlebuf) {
+	SDL_OutOfMemory();
+	return NULL;
+    }
+    {
+	/* save the destination format so we can undo the encoding later */
+	RLEDestFormat *r = (RLEDestFormat *)rlebuf;
+	r->BytesPerPixel = df->BytesPerPixel;
+	r->Rloss = df->Rloss;
+	r->Gloss = df->Gloss;
+	r->Bloss = df->Bloss;
+	r->Rshift = df->Rshift;
+	r->Gshift = df->Gshift;
+	r->Bshift = df->Bshift;
+	r->Ashift = df->Ashift;
+	r->Rmask = df->Rmask;
+	r->Gmask = df->Gmask;
+	r->Bmask = df->Bmask;
+	r->Amask = df->Amask;
     }
 
+    /* Do the actual encoding */
+    dst = RLEEncodeLines(&enc, rlebuf + sizeof(RLEDestFormat));
+    ADD_OPAQUE_COUNTS(0, 0);
+
+#undef ADD_OPAQUE_COUNTS
+
     /* realloc the buffer to release unused memory */
     {
 	Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
 	if(!p)
 	    p = rlebuf;
-	surface->map->sw_data->aux_data = p;
+	*length = dst - rlebuf;
+	return p;
     }
-
-    return 0;
 }
 
 static Uint32 getpix_8(Uint8 *srcbuf)
@@ -1640,54 +1750,28 @@ static getpix_func getpixes[4] = {
     getpix_8, getpix_16, getpix_24, getpix_32
 };
 
-static int RLEColorkeySurface(SDL_Surface *surface)
+/* encode a band of a colorkeyed surface */
+static void RLEColorkeyBand(RLEEncoder *enc, RLEBand *band)
 {
-        Uint8 *rlebuf, *dst;
+	SDL_Surface *surface = enc->surface;
+	Uint8 *dst;
 	int maxn;
 	int y;
 	Uint8 *srcbuf, *lastline;
-	int maxsize = 0;
 	int bpp = surface->format->BytesPerPixel;
 	getpix_func getpix;
 	Uint32 ckey, rgbmask;
-	int w, h;
-
-	/* calculate the worst case size for the compressed surface */
-	switch(bpp) {
-	case 1:
-	    /* worst case is alternating opaque and transparent pixels,
-	       starting with an opaque pixel */
-	    maxsize = surface->h * 3 * (surface->w / 2 + 1) + 2;
-	    break;
-	case 2:
-	case 3:
-	    /* worst case is solid runs, at most 255 pixels wide */
-	    maxsize = surface->h * (2 * (surface->w / 255 + 1)
-				    + surface->w * bpp) + 2;
-	    break;
-	case 4:
-	    /* worst case is solid runs, at most 65535 pixels wide */
-	    maxsize = surface->h * (4 * (surface->w / 65535 + 1)
-				    + surface->w * 4) + 4;
-	    break;
-	}
-
-	rlebuf = (Uint8 *)SDL_malloc(maxsize);
-	if ( rlebuf == NULL ) {
-		SDL_OutOfMemory();
-		return(-1);
-	}
+	int w;
 
 	/* Set up the conversion */
-	srcbuf = (Uint8 *)surface->pixels;
+	srcbuf = (Uint8 *)surface->pixels + band->y * surface->pitch;
 	maxn = bpp == 4 ? 65535 : 255;
-	dst = rlebuf;
+	dst = band->buf;
 	rgbmask = ~surface->format->Amask;
 	ckey = surface->format->colorkey & rgbmask;
 	lastline = dst;
 	getpix = getpixes[bpp - 1];
 	w = surface->w;
-	h = surface->h;
 
 #define ADD_COUNTS(n, m)			\
 	if(bpp == 4) {				\
@@ -1700,7 +1784,7 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 	    dst += 2;				\
 	}
 
-	for(y = 0; y < h; y++) {
+	for(y = 0; y < band->h; y++) {
 	    int x = 0;
 	    int blankline = 0;
 	    do {
@@ -1744,16 +1828,65 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 
 	    srcbuf += surface->pitch;
 	}
-	dst = lastline;		/* back up bast trailing blank lines */
-	ADD_COUNTS(0, 0);
 
 #undef ADD_COUNTS
 
-	/* Now that we have it encoded, release the original pixels */
-	if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
-	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
-	    SDL_free( surface->pixels );
-	    surface->pixels = NULL;
+	band->size = dst - band->buf;
+	band->lastline = lastline - band->buf;
+}
+
+static Uint8 *RLEColorkeySurface(SDL_Surface *surface, int *length)
+{
+        Uint8 *rlebuf, *dst;
+	int maxsize = 0;
+	int bpp = surface->format->BytesPerPixel;
+	RLEEncoder enc;
+
+	SDL_memset(&enc, 0, sizeof(enc));
+	enc.surface = surface;
+	enc.encode = RLEColorkeyBand;
+
+	/* calculate the worst case size for the compressed surface */
+	switch(bpp) {
+	case 1:
+	    /* worst case is alternating opaque and transparent pixels,
+	       starting with an opaque pixel */
+	    enc.linesize = 3 * (surface->w / 2 + 1);
+	    maxsize = surface->h * enc.linesize + 2;
+	    break;
+	case 2:
+	case 3:
+	    /* worst case is solid runs, at most 255 pixels wide */
+	    enc.linesize = 2 * (surface->w / 255 + 1) + surface->w * bpp;
+	    maxsize = surface->h * enc.linesize + 2;
+	    break;
+	case 4:
+	    /* worst case is solid runs, at most 65535 pixels wide */
+	    enc.linesize = 4 * (surface->w / 65535 + 1) + surface->w * 4;
+	    maxsize = surface->h * enc.linesize + 4;
+	    break;
+	}
+
+	/* every scan line is a whole number of counts and pixels,
+	   so the bands stay aligned wherever they end up */
+	enc.parallel = 1;
+
+	rlebuf = (Uint8 *)SDL_malloc(maxsize);
+	if ( rlebuf == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+
+	/* back up past trailing blank lines and add the end marker */
+	dst = RLEEncodeLines(&enc, rlebuf);
+	if(bpp == 4) {
+	    ((Uint16 *)dst)[0] = 0;
+	    ((Uint16 *)dst)[1] = 0;
+	    dst += 4;
+	} else {
+	    dst[0] = 0;
+	    dst[1] = 0;
+	    dst += 2;
 	}
 
 	/* realloc the buffer to release unused memory */
@@ -1762,19 +1895,73 @@ static int RLEColorkeySurface(SDL_Surface *surface)
 	    Uint8 *p = SDL_realloc(rlebuf, dst - rlebuf);
 	    if(!p)
 		p = rlebuf;
-	    surface->map->sw_data->aux_data = p;
+	    *length = dst - rlebuf;
+	    return(p);
 	}
+}
 
-	return(0);
+/*
+ * The last encoding of a surface is kept in its blit map, and reused when
+ * the surface is encoded again without its pixels having been touched in
+ * between, for instance when it's blitted to a new destination. It can
+ * also be saved with SDL_SaveRLE_RW() and given to another surface with
+ * the same contents with SDL_LoadRLE_RW(), so assets can be shipped
+ * pre-encoded.
+ */
+#define RLE_COLORKEY	1
+#define RLE_ALPHA	2
+
+struct SDL_RLECache {
+	int kind;		/* RLE_COLORKEY or RLE_ALPHA */
+	Uint32 colorkey;	/* key a colorkey encoding was made for */
+	int length;
+	Uint8 *data;
+};
+
+void SDL_FreeRLECache(SDL_BlitMap *map)
+{
+	if ( map && map->rle_cache ) {
+		SDL_free(map->rle_cache->data);
+		SDL_free(map->rle_cache);
+		map->rle_cache = NULL;
+	}
+}
+
+/* See if the kept encoding is the one we would make now */
+static SDL_bool RLECacheMatches(SDL_Surface *surface, int kind)
+{
+	struct SDL_RLECache *cache = surface->map->rle_cache;
+
+	if ( !cache || cache->kind != kind ) {
+		return(SDL_FALSE);
+	}
+	if ( kind == RLE_COLORKEY ) {
+		Uint32 ckey = surface->format->colorkey & ~surface->format->Amask;
+		return(cache->colorkey == ckey);
+	} else {
+		RLEDestFormat *r = (RLEDestFormat *)cache->data;
+		SDL_PixelFormat *df;
+
+		if ( !surface->map->dst ) {
+			return(SDL_FALSE);
+		}
+		df = surface->map->dst->format;
+		return(r->BytesPerPixel == df->BytesPerPixel &&
+		       r->Rmask == df->Rmask && r->Gmask == df->Gmask &&
+		       r->Bmask == df->Bmask && r->Amask == df->Amask);
+	}
 }
 
 int SDL_RLESurface(SDL_Surface *surface)
 {
-	int retcode;
+	struct SDL_RLECache *cache;
+	Uint8 *rlebuf;
+	int length;
+	int kind;
 
-	/* Clear any previous RLE conversion */
+	/* Clear any previous RLE conversion, but keep the encoding */
 	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		SDL_UnRLESurface(surface, 1);
+		SDL_UnRLESurface(surface, 2);
 	}
 
 	/* We don't support RLE encoding of bitmaps */
@@ -1782,31 +1969,62 @@ int SDL_RLESurface(SDL_Surface *surface)
 		return(-1);
 	}
 
-	/* Lock the surface if it's in hardware */
-	if ( SDL_MUSTLOCK(surface) ) {
-		if ( SDL_LockSurface(surface) < 0 ) {
-			return(-1);
-		}
-	}
-
-	/* Encode */
 	if((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY) {
-	    retcode = RLEColorkeySurface(surface);
+	    kind = RLE_COLORKEY;
 	} else {
 	    if((surface->flags & SDL_SRCALPHA) == SDL_SRCALPHA
 	       && surface->format->Amask != 0)
-		retcode = RLEAlphaSurface(surface);
+		kind = RLE_ALPHA;
 	    else
-		retcode = -1;	/* no RLE for per-surface alpha sans ckey */
+		return(-1);	/* no RLE for per-surface alpha sans ckey */
 	}
 
-	/* Unlock the surface if it's in hardware */
-	if ( SDL_MUSTLOCK(surface) ) {
-		SDL_UnlockSurface(surface);
+	if ( !RLECacheMatches(surface, kind) ) {
+		SDL_FreeRLECache(surface->map);
+
+		/* Lock the surface if it's in hardware */
+		if ( SDL_MUSTLOCK(surface) ) {
+			if ( SDL_LockSurface(surface) < 0 ) {
+				return(-1);
+			}
+		}
+
+		/* Encode */
+		if ( kind == RLE_COLORKEY ) {
+			rlebuf = RLEColorkeySurface(surface, &length);
+		} else {
+			rlebuf = RLEAlphaSurface(surface, &length);
+		}
+
+		/* Unlock the surface if it's in hardware */
+		if ( SDL_MUSTLOCK(surface) ) {
+			SDL_UnlockSurface(surface);
+		}
+
+		if ( rlebuf == NULL ) {
+			return(-1);
+		}
+
+		cache = (struct SDL_RLECache *)SDL_malloc(sizeof(*cache));
+		if ( cache == NULL ) {
+			SDL_free(rlebuf);
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		cache->kind = kind;
+		cache->colorkey = surface->format->colorkey & ~surface->format->Amask;
+		cache->length = length;
+		cache->data = rlebuf;
+		surface->map->rle_cache = cache;
 	}
 
-	if(retcode < 0)
-	    return -1;
+	/* Now that we have it encoded, release the original pixels */
+	if((surface->flags & SDL_PREALLOC) != SDL_PREALLOC
+	   && (surface->flags & SDL_HWSURFACE) != SDL_HWSURFACE) {
+	    SDL_free( surface->pixels );
+	    surface->pixels = NULL;
+	}
+	surface->map->sw_data->aux_data = surface->map->rle_cache->data;
 
 	/* The surface is now accelerated */
 	surface->flags |= SDL_RLEACCEL;
@@ -1895,6 +2113,14 @@ static SDL_bool UnRLEAlpha(SDL_Surface *surface)
 void SDL_UnRLESurface(SDL_Surface *surface, int recode)
 {
     if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
+	struct SDL_RLECache *cache = NULL;
+
+	/* Keep the encoding out of reach while the pixels are restored,
+	   so locking the surface to do it doesn't throw it away */
+	if ( surface->map ) {
+	    cache = surface->map->rle_cache;
+	    surface->map->rle_cache = NULL;
+	}
 	surface->flags &= ~SDL_RLEACCEL;
 
 	if(recode && (surface->flags & SDL_PREALLOC) != SDL_PREALLOC
@@ -1907,6 +2133,7 @@ void SDL_UnRLESurface(SDL_Surface *surface, int recode)
 		surface->pixels = SDL_malloc(surface->h * surface->pitch);
 		if ( !surface->pixels ) {
 			/* Oh crap... */
+			surface->map->rle_cache = cache;
 			surface->flags |= SDL_RLEACCEL;
 			return;
 		}
@@ -1925,17 +2152,280 @@ void SDL_UnRLESurface(SDL_Surface *surface, int recode)
 	    } else {
 		if ( !UnRLEAlpha(surface) ) {
 		    /* Oh crap... */
+		    surface->map->rle_cache = cache;
 		    surface->flags |= SDL_RLEACCEL;
 		    return;
 		}
 	    }
 	}
 
-	if ( surface->map && surface->map->sw_data->aux_data ) {
-	    SDL_free(surface->map->sw_data->aux_data);
+	if ( surface->map ) {
+	    /* The encoding lives on in the cache when recode is 2 */
 	    surface->map->sw_data->aux_data = NULL;
+	    surface->map->rle_cache = cache;
+	    if ( recode != 2 ) {
+		SDL_FreeRLECache(surface->map);
+	    }
 	}
     }
 }
 
+/* Serialized encodings, see SDL_SaveRLE_RW() */
+#define RLE_FILE_MAGIC		0x454C5253	/* "SRLE" */
+#define RLE_FILE_VERSION	1
+
+int SDL_SaveRLE_RW(SDL_Surface *surface, SDL_RWops *dst, int freedst)
+{
+	struct SDL_RLECache *cache;
+	SDL_PixelFormat *fmt;
+	int retval;
+
+	retval = -1;
+	cache = surface->map ? surface->map->rle_cache : NULL;
+	if ( !dst ) {
+		/* SDL_RWFromFile() has already set the error */
+	} else if ( !cache ) {
+		SDL_SetError("Surface has no RLE encoding to save");
+	} else {
+		fmt = surface->format;
+		SDL_ClearError();
+		SDL_WriteLE32(dst, RLE_FILE_MAGIC);
+		SDL_WriteLE32(dst, RLE_FILE_VERSION);
+		SDL_WriteLE32(dst, SDL_BYTEORDER);
+		SDL_WriteLE32(dst, cache->kind);
+		SDL_WriteLE32(dst, surface->w);
+		SDL_WriteLE32(dst, surface->h);
+		SDL_WriteLE32(dst, fmt->BitsPerPixel);
+		SDL_WriteLE32(dst, fmt->Rmask);
+		SDL_WriteLE32(dst, fmt->Gmask);
+		SDL_WriteLE32(dst, fmt->Bmask);
+		SDL_WriteLE32(dst, fmt->Amask);
+		SDL_WriteLE32(dst, cache->colorkey);
+		SDL_WriteLE32(dst, cache->length);
+		if ( SDL_RWwrite(dst, cache->data, cache->length, 1) != 1 ) {
+			SDL_Error(SDL_EFWRITE);
+		} else if ( SDL_strcmp(SDL_GetError(), "") == 0 ) {
+			retval = 0;
+		}
+	}
+	if ( dst && freedst ) {
+		SDL_RWclose(dst);
+	}
+	return(retval);
+}
+
+/*
+ * Walk a loaded encoding the way the blitters do, and make sure that no
+ * run goes past the end of a scan line, there are no more lines than the
+ * surface has, and the end marker comes before the end of the data.
+ */
+#define RLE_COUNTS(p, csize, n, m)				\
+	if ( csize == 2 ) {					\
+		n = ((Uint16 *)(p))[0];				\
+		m = ((Uint16 *)(p))[1];				\
+	} else {						\
+		n = (p)[0];					\
+		m = (p)[1];					\
+	}
+
+static SDL_bool RLECheckColorkey(SDL_Surface *surface, Uint8 *buf, int length)
+{
+	int bpp = surface->format->BytesPerPixel;
+	int csize = (bpp == 4) ? 2 : 1;
+	int pos, ofs, lines;
+	unsigned skip, run;
+
+	pos = 0;
+	ofs = 0;
+	lines = 0;
+	for ( ;; ) {
+		if ( length - pos < 2 * csize ) {
+			return(SDL_FALSE);
+		}
+		RLE_COUNTS(buf + pos, csize, skip, run);
+		pos += 2 * csize;
+		if ( !ofs && !skip && !run ) {
+			return(SDL_TRUE);		/* end marker */
+		}
+		if ( lines == surface->h ||
+		     skip + run > (unsigned)(surface->w - ofs) ||
+		     (unsigned)(length - pos) / bpp < run ) {
+			return(SDL_FALSE);
+		}
+		pos += run * bpp;
+		ofs += skip + run;
+		if ( ofs == surface->w ) {
+			ofs = 0;
+			++lines;
+		}
+	}
+}
+
+static SDL_bool RLECheckAlpha(SDL_Surface *surface, Uint8 *buf, int length)
+{
+	RLEDestFormat *df = (RLEDestFormat *)buf;
+	int bpp, csize;
+	int pos, ofs, lines;
+	unsigned skip, run;
+
+	/* The encoding is only made from 32-bit surfaces */
+	if ( surface->format->BytesPerPixel != 4 ||
+	     length < (int)sizeof(RLEDestFormat) ) {
+		return(SDL_FALSE);
+	}
+	bpp = df->BytesPerPixel;
+	if ( bpp != 2 && bpp != 4 ) {
+		return(SDL_FALSE);
+	}
+	csize = (bpp == 4) ? 2 : 1;
+
+	pos = sizeof(RLEDestFormat);
+	lines = 0;
+	for ( ;; ) {
+		/* opaque pixels, in the destination format */
+		ofs = 0;
+		do {
+			if ( length - pos < 2 * csize ) {
+				return(SDL_FALSE);
+			}
+			RLE_COUNTS(buf + pos, csize, skip, run);
+			pos += 2 * csize;
+			if ( !ofs && !skip && !run ) {
+				return(SDL_TRUE);	/* end marker */
+			}
+			if ( lines == surface->h ||
+			     skip + run > (unsigned)(surface->w - ofs) ||
+			     (unsigned)(length - pos) / bpp < run ) {
+				return(SDL_FALSE);
+			}
+			pos += run * bpp;
+			ofs += skip + run;
+		} while ( ofs < surface->w );
+
+		/* padding, which depends on the address like in the blitters */
+		if ( bpp == 2 ) {
+			pos += (uintptr_t)(buf + pos) & 2;
+		}
+
+		/* translucent pixels, always 32 bits with 16-bit counts */
+		ofs = 0;
+		do {
+			if ( length - pos < 4 ) {
+				return(SDL_FALSE);
+			}
+			RLE_COUNTS(buf + pos, 2, skip, run);
+			pos += 4;
+			if ( skip + run > (unsigned)(surface->w - ofs) ||
+			     (unsigned)(length - pos) / 4 < run ) {
+				return(SDL_FALSE);
+			}
+			pos += run * 4;
+			ofs += skip + run;
+		} while ( ofs < surface->w );
+		++lines;
+	}
+}
+
+#undef RLE_COUNTS
+
+int SDL_LoadRLE_RW(SDL_Surface *surface, SDL_RWops *src, int freesrc)
+{
+	struct SDL_RLECache *cache;
+	SDL_PixelFormat *fmt;
+	Uint32 header[13];
+	Uint32 maxsize;
+	int i;
+
+	cache = NULL;
+	if ( !src ) {
+		goto error;
+	}
+	if ( surface->format->BitsPerPixel < 8 ) {
+		SDL_SetError("RLE encoding not supported for bitmaps");
+		goto error;
+	}
+	for ( i=0; i<SDL_arraysize(header); ++i ) {
+		if ( SDL_RWread(src, &header[i], 4, 1) != 1 ) {
+			SDL_Error(SDL_EFREAD);
+			goto error;
+		}
+		header[i] = SDL_SwapLE32(header[i]);
+	}
+	if ( header[0] != RLE_FILE_MAGIC || header[1] != RLE_FILE_VERSION ) {
+		SDL_SetError("File is not an RLE encoding");
+		goto error;
+	}
+	if ( header[2] != SDL_BYTEORDER ) {
+		SDL_SetError("RLE encoding was made with a different byte order");
+		goto error;
+	}
 
+	/* The encoding is only good for a surface just like the one saved */
+	fmt = surface->format;
+	if ( (header[3] != RLE_COLORKEY && header[3] != RLE_ALPHA) ||
+	     header[4] != (Uint32)surface->w ||
+	     header[5] != (Uint32)surface->h ||
+	     header[6] != fmt->BitsPerPixel ||
+	     header[7] != fmt->Rmask || header[8] != fmt->Gmask ||
+	     header[9] != fmt->Bmask || header[10] != fmt->Amask ) {
+		SDL_SetError("RLE encoding doesn't match the surface");
+		goto error;
+	}
+
+	/* No encoding is larger than alternating 32-bit runs */
+	maxsize = surface->h * (2 * 4 * (surface->w + 1) + 2)
+	          + sizeof(RLEDestFormat) + 4;
+	if ( header[12] == 0 || header[12] > maxsize ) {
+		SDL_SetError("Corrupt RLE encoding");
+		goto error;
+	}
+
+	cache = (struct SDL_RLECache *)SDL_malloc(sizeof(*cache));
+	if ( cache ) {
+		cache->data = (Uint8 *)SDL_malloc(header[12]);
+		if ( !cache->data ) {
+			SDL_free(cache);
+			cache = NULL;
+		}
+	}
+	if ( !cache ) {
+		SDL_OutOfMemory();
+		goto error;
+	}
+	cache->kind = header[3];
+	cache->colorkey = header[11];
+	cache->length = header[12];
+	if ( SDL_RWread(src, cache->data, cache->length, 1) != 1 ) {
+		SDL_Error(SDL_EFREAD);
+		goto error;
+	}
+	if ( cache->kind == RLE_COLORKEY ?
+	     !RLECheckColorkey(surface, cache->data, cache->length) :
+	     !RLECheckAlpha(surface, cache->data, cache->length) ) {
+		SDL_SetError("Corrupt RLE encoding");
+		goto error;
+	}
+	if ( freesrc ) {
+		SDL_RWclose(src);
+	}
+
+	/* Replace any encoding the surface has, and remap it on the next
+	   blit so the new one gets picked up */
+	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
+		SDL_UnRLESurface(surface, 1);
+	}
+	SDL_FreeRLECache(surface->map);
+	surface->map->rle_cache = cache;
+	SDL_InvalidateMap(surface->map);
+	return(0);
+
+error:
+	if ( cache ) {
+		SDL_free(cache->data);
+		SDL_free(cache);
+	}
+	if ( src && freesrc ) {
+		SDL_RWclose(src);
+	}
+	return(-1);
+}
@@ -26,16 +26,24 @@
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_cpuinfo.h"
 
-#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && SDL_ASSEMBLY_ROUTINES
+#if SDL_ASSEMBLY_ROUTINES
+#if defined(__SSE2__) || (defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))))
+/* x86_64 and SSE2 builds: the C library copy is tuned for the CPU, only
+   copies too big for the cache get our own streaming version. */
+#define SSE2_BLITCOPY
+#elif defined(__GNUC__) && defined(__i386__)
 #define MMX_ASMBLIT
 #if (__GNUC__ > 2)  /* SSE instructions aren't in GCC 2. */
 #define SSE_ASMBLIT
 #endif
 #endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
 
-#if defined(MMX_ASMBLIT)
-#include "SDL_cpuinfo.h"
+#if defined(SSE2_BLITCOPY)
+#include <emmintrin.h>
+#elif defined(MMX_ASMBLIT)
 #include "mmx.h"
 #endif
 
@@ -152,11 +160,65 @@ static __inline__ void SDL_memcpySSE(Uint8 *to, const Uint8 *from, int len)
 #endif
 #endif
 
+#ifdef SSE2_BLITCOPY
+/* Copy with streaming stores, prefetching the source well ahead */
+static void SDL_memcpySSE2(Uint8 *to, const Uint8 *from, int len)
+{
+	int head = (int)((16 - ((uintptr_t)to & 15)) & 15);
+
+	if ( head > len ) {
+		head = len;
+	}
+	SDL_memcpy(to, from, head);
+	to += head;
+	from += head;
+	len -= head;
+
+	for ( ; len >= 64; len -= 64 ) {
+		__m128i v0, v1, v2, v3;
+		_mm_prefetch((const char *)(from + 512), _MM_HINT_NTA);
+		v0 = _mm_loadu_si128((const __m128i *)(from +  0));
+		v1 = _mm_loadu_si128((const __m128i *)(from + 16));
+		v2 = _mm_loadu_si128((const __m128i *)(from + 32));
+		v3 = _mm_loadu_si128((const __m128i *)(from + 48));
+		_mm_stream_si128((__m128i *)(to +  0), v0);
+		_mm_stream_si128((__m128i *)(to + 16), v1);
+		_mm_stream_si128((__m128i *)(to + 32), v2);
+		_mm_stream_si128((__m128i *)(to + 48), v3);
+		from += 64;
+		to += 64;
+	}
+	SDL_memcpy(to, from, len);
+}
+#endif /* SSE2_BLITCOPY */
+
+/* The CPU features SDL_BlitCopy() uses to copy 'len' bytes in all */
+static Uint32 SDL_BlitCopyFeatures(int len)
+{
+#ifdef SSE2_BLITCOPY
+	if ( (len > SDL_GetStreamThreshold()) && SDL_HasSSE2() ) {
+		return(SDL_BLITCPU_SSE2);
+	}
+#endif
+#ifdef SSE_ASMBLIT
+	if ( SDL_HasSSE() ) {
+		return(SDL_BLITCPU_SSE | SDL_BLITCPU_MMX);
+	}
+#endif
+#ifdef MMX_ASMBLIT
+	if ( SDL_HasMMX() ) {
+		return(SDL_BLITCPU_MMX);
+	}
+#endif
+	return(0);
+}
+
 static void SDL_BlitCopy(SDL_BlitInfo *info)
 {
 	Uint8 *src, *dst;
 	int w, h;
 	int srcskip, dstskip;
+	Uint32 features;
 
 	w = info->d_width*info->dst->BytesPerPixel;
 	h = info->d_height;
@@ -165,8 +227,26 @@ static void SDL_BlitCopy(SDL_BlitInfo *info)
 	srcskip = w+info->s_skip;
 	dstskip = w+info->d_skip;
 
+	/* Rows that follow each other without padding are one big copy */
+	if ( !info->s_skip && !info->d_skip ) {
+		w *= h;
+		h = 1;
+	}
+
+	features = SDL_BlitCopyFeatures(w*h);
+#ifdef SSE2_BLITCOPY
+	if ( features & SDL_BLITCPU_SSE2 ) {
+		while ( h-- ) {
+			SDL_memcpySSE2(dst, src, w);
+			src += srcskip;
+			dst += dstskip;
+		}
+		_mm_sfence();
+		return;
+	}
+#endif
 #ifdef SSE_ASMBLIT
-	if(SDL_HasSSE())
+	if ( features & SDL_BLITCPU_SSE )
 	{
 		while ( h-- ) {
 			SDL_memcpySSE(dst, src, w);
@@ -180,7 +260,7 @@ static void SDL_BlitCopy(SDL_BlitInfo *info)
 	else
 #endif
 #ifdef MMX_ASMBLIT
-	if(SDL_HasMMX())
+	if ( features & SDL_BLITCPU_MMX )
 	{
 		while ( h-- ) {
 			SDL_memcpyMMX(dst, src, w);
@@ -229,14 +309,119 @@ static void SDL_BlitCopyOverlap(SDL_BlitInfo *info)
 	}
 }
 
+int SDL_GetStreamThreshold(void)
+{
+	static int threshold = 0;
+
+	if ( !threshold ) {
+		threshold = SDL_GetCPUCacheSize(3);
+		if ( !threshold ) {
+			threshold = SDL_GetCPUCacheSize(2);
+		}
+		if ( !threshold ) {
+			threshold = SDL_STREAM_THRESHOLD;
+		}
+	}
+	return(threshold);
+}
+
+/* The names of the blit functions, for diagnostics */
+static const SDL_BlitName SDL_BlitNamesCopy[] = {
+	SDL_BLIT_NAME(SDL_BlitCopy, 0),
+	SDL_BLIT_NAME(SDL_BlitCopyOverlap, 0),
+	{ NULL, NULL, 0 }
+};
+static const SDL_BlitName *blit_names[] = {
+	SDL_BlitNamesCopy, SDL_BlitNames0, SDL_BlitNames1,
+	SDL_BlitNamesN, SDL_BlitNamesA
+};
+
+const char *SDL_GetBlitName(SDL_loblit blit, Uint32 *features)
+{
+	const SDL_BlitName *entry;
+	int i;
+
+	for ( i = 0; i < SDL_arraysize(blit_names); ++i ) {
+		for ( entry = blit_names[i]; entry->blit; ++entry ) {
+			if ( entry->blit == blit ) {
+				if ( features ) {
+					*features = entry->features;
+				}
+				return(entry->name);
+			}
+		}
+	}
+	if ( features ) {
+		*features = 0;
+	}
+	return("unknown");
+}
+
+/* Describe the blit set up on a surface by SDL_CalculateBlit() */
+static void SDL_DescribeBlit(SDL_Surface *surface, const char **method,
+                             const char **kernel, Uint32 *features)
+{
+	SDL_BlitMap *map = surface->map;
+
+	*features = 0;
+	if ( (surface->flags & SDL_HWACCEL) == SDL_HWACCEL ) {
+		*method = "hardware";
+		*kernel = current_video->name;
+	} else if ( map->sw_blit == SDL_RLEBlit ) {
+		*method = "rle";
+		*kernel = "SDL_RLEBlit";
+	} else if ( map->sw_blit == SDL_RLEAlphaBlit ) {
+		*method = "rle";
+		*kernel = "SDL_RLEAlphaBlit";
+	} else {
+		*method = "software";
+		*kernel = SDL_GetBlitName(map->sw_data->blit, features);
+
+		/* The plain copy picks its routine when it runs, so describe
+		   the one it uses for the whole surface */
+		if ( map->sw_data->blit == SDL_BlitCopy ) {
+			*features = SDL_BlitCopyFeatures(surface->w * surface->h *
+			                                 surface->format->BytesPerPixel);
+		}
+	}
+}
+
+static void SDL_LogBlit(SDL_Surface *surface)
+{
+	static const char *feature_names[] = {
+		"MMX", "3DNow", "SSE", "SSE2", "AltiVec", "ARM SIMD", "ARM NEON"
+	};
+	SDL_PixelFormat *src = surface->format;
+	SDL_PixelFormat *dst = surface->map->dst->format;
+	const char *method, *kernel;
+	Uint32 features;
+	int i;
+
+	SDL_DescribeBlit(surface, &method, &kernel, &features);
+	fprintf(stderr, "SDL blit: %d bpp %.8X/%.8X/%.8X/%.8X%s%s -> "
+	                "%d bpp %.8X/%.8X/%.8X/%.8X: %s %s",
+		src->BitsPerPixel, src->Rmask, src->Gmask, src->Bmask, src->Amask,
+		(surface->flags & SDL_SRCCOLORKEY) ? " colorkey" : "",
+		(surface->flags & SDL_SRCALPHA) ? " alpha" : "",
+		dst->BitsPerPixel, dst->Rmask, dst->Gmask, dst->Bmask, dst->Amask,
+		method, kernel);
+	for ( i = 0; i < SDL_arraysize(feature_names); ++i ) {
+		if ( features & (1 << i) ) {
+			fprintf(stderr, " %s", feature_names[i]);
+		}
+	}
+	fprintf(stderr, "\n");
+}
+
 /* Figure out which of many blit routines to set up on a surface */
 int SDL_CalculateBlit(SDL_Surface *surface)
 {
 	int blit_index;
 
-	/* Clean everything out to start */
+	/* Clean everything out to start, keeping the RLE encoding in case
+	   it can be used again */
 	if ( (surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		SDL_UnRLESurface(surface, 1);
+		SDL_UnRLESurface(surface, 2);
 	}
 	surface->map->sw_blit = NULL;
 
@@ -332,6 +517,7 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 	}
 	/* Make sure we have a blit function */
 	if ( surface->map->sw_data->blit == NULL ) {
+		SDL_FreeRLECache(surface->map);
 		SDL_InvalidateMap(surface->map);
 		SDL_SetError("Blit combination not supported");
 		return(-1);
@@ -355,6 +541,44 @@ int SDL_CalculateBlit(SDL_Surface *surface)
 	if ( surface->map->sw_blit == NULL ) {
 		surface->map->sw_blit = SDL_SoftBlit;
 	}
+
+	/* An encoding that wasn't used again won't be needed any more */
+	if ( (surface->flags & SDL_RLEACCEL) != SDL_RLEACCEL ) {
+		SDL_FreeRLECache(surface->map);
+	}
+
+	if ( SDL_getenv("SDL_BLIT_LOG") ) {
+		SDL_LogBlit(surface);
+	}
+	return(0);
+}
+
+int SDL_GetBlitInfo(SDL_Surface *src, SDL_Surface *dst, const char **method,
+                    const char **kernel, Uint32 *features)
+{
+	const char *the_method, *the_kernel;
+	Uint32 the_features;
+
+	if ( !src || !dst ) {
+		SDL_SetError("SDL_GetBlitInfo: passed a NULL surface");
+		return(-1);
+	}
+	if ( (src->map->dst != dst) ||
+             (src->map->dst->format_version != src->map->format_version) ) {
+		if ( SDL_MapSurface(src, dst) < 0 ) {
+			return(-1);
+		}
+	}
+	SDL_DescribeBlit(src, &the_method, &the_kernel, &the_features);
+	if ( method ) {
+		*method = the_method;
+	}
+	if ( kernel ) {
+		*kernel = the_kernel;
+	}
+	if ( features ) {
+		*features = the_features;
+	}
 	return(0);
 }
 
@@ -61,14 +61,37 @@ typedef struct SDL_BlitMap {
 	struct private_hwaccel *hw_data;
 	struct private_swaccel *sw_data;
 
+	/* the last RLE encoding, kept while the pixels are unchanged */
+	struct SDL_RLECache *rle_cache;
+
 	/* the version count matches the destination; mismatch indicates
 	   an invalid mapping */
         unsigned int format_version;
 } SDL_BlitMap;
 
 
+/* Fills and copies bigger than the last level cache are assumed not to
+   fit in it, and are done with streaming stores where they're available.
+   This is the size used when the cache size can't be found out. */
+#define SDL_STREAM_THRESHOLD	(4*1024*1024)
+
+/* The name of a low level blit function and the CPU features it needs,
+   used to report which blitter was chosen for a surface */
+typedef struct SDL_BlitName {
+	SDL_loblit blit;
+	const char *name;
+	Uint32 features;	/* SDL_BLITCPU_* flags */
+} SDL_BlitName;
+
+#define SDL_BLIT_NAME(blit, features)	{ blit, #blit, features }
+
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface *surface);
+extern int SDL_GetStreamThreshold(void);
+extern const char *SDL_GetBlitName(SDL_loblit blit, Uint32 *features);
+
+/* Functions found in SDL_surface.c */
+extern void SDL_FillRectSoftware(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
 
 /* Functions found in SDL_blit_{0,1,N,A}.c */
 extern SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int complex);
@@ -76,6 +99,12 @@ extern SDL_loblit SDL_CalculateBlit1(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int complex);
 extern SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int complex);
 
+/* The blit functions in SDL_blit_{0,1,N,A}.c, terminated by a NULL entry */
+extern const SDL_BlitName SDL_BlitNames0[];
+extern const SDL_BlitName SDL_BlitNames1[];
+extern const SDL_BlitName SDL_BlitNamesN[];
+extern const SDL_BlitName SDL_BlitNamesA[];
+
 /*
  * Useful macros for blitting routines
  */
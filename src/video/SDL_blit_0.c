@@ -469,3 +469,17 @@ SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int blit_index)
 	return NULL;
 }
 
+
+const SDL_BlitName SDL_BlitNames0[] = {
+	SDL_BLIT_NAME(BlitBto1, 0),
+	SDL_BLIT_NAME(BlitBto2, 0),
+	SDL_BLIT_NAME(BlitBto3, 0),
+	SDL_BLIT_NAME(BlitBto4, 0),
+	SDL_BLIT_NAME(BlitBto1Key, 0),
+	SDL_BLIT_NAME(BlitBto2Key, 0),
+	SDL_BLIT_NAME(BlitBto3Key, 0),
+	SDL_BLIT_NAME(BlitBto4Key, 0),
+	SDL_BLIT_NAME(BlitBtoNAlpha, 0),
+	SDL_BLIT_NAME(BlitBtoNAlphaKey, 0),
+	{ NULL, NULL, 0 }
+};
@@ -521,3 +521,17 @@ SDL_loblit SDL_CalculateBlit1(SDL_Surface *surface, int blit_index)
 	}
 	return NULL;
 }
+
+const SDL_BlitName SDL_BlitNames1[] = {
+	SDL_BLIT_NAME(Blit1to1, 0),
+	SDL_BLIT_NAME(Blit1to2, 0),
+	SDL_BLIT_NAME(Blit1to3, 0),
+	SDL_BLIT_NAME(Blit1to4, 0),
+	SDL_BLIT_NAME(Blit1to1Key, 0),
+	SDL_BLIT_NAME(Blit1to2Key, 0),
+	SDL_BLIT_NAME(Blit1to3Key, 0),
+	SDL_BLIT_NAME(Blit1to4Key, 0),
+	SDL_BLIT_NAME(Blit1toNAlpha, 0),
+	SDL_BLIT_NAME(Blit1toNAlphaKey, 0),
+	{ NULL, NULL, 0 }
+};
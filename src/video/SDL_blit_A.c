@@ -2955,3 +2955,42 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
     }
 }
 
+
+const SDL_BlitName SDL_BlitNamesA[] = {
+#if GCC_ASMBLIT || MSVC_ASMBLIT
+	SDL_BLIT_NAME(BlitRGBtoRGBSurfaceAlphaMMX, SDL_BLITCPU_MMX),
+	SDL_BLIT_NAME(BlitRGBtoRGBPixelAlphaMMX, SDL_BLITCPU_MMX),
+	SDL_BLIT_NAME(BlitRGBtoRGBPixelAlphaMMX3DNOW, SDL_BLITCPU_MMX|SDL_BLITCPU_3DNOW),
+	SDL_BLIT_NAME(Blit565to565SurfaceAlphaMMX, SDL_BLITCPU_MMX),
+	SDL_BLIT_NAME(Blit555to555SurfaceAlphaMMX, SDL_BLITCPU_MMX),
+#endif
+#if SDL_ALTIVEC_BLITTERS
+	SDL_BLIT_NAME(Blit32to565PixelAlphaAltivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(Blit32to32SurfaceAlphaKeyAltivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(Blit32to32PixelAlphaAltivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(BlitRGBtoRGBPixelAlphaAltivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(Blit32to32SurfaceAlphaAltivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(BlitRGBtoRGBSurfaceAlphaAltivec, SDL_BLITCPU_ALTIVEC),
+#endif
+#if SDL_ARM_SIMD_BLITTERS
+	SDL_BLIT_NAME(BlitARGBto565PixelAlphaARMSIMD, SDL_BLITCPU_ARMSIMD),
+	SDL_BLIT_NAME(BlitRGBtoRGBPixelAlphaARMSIMD, SDL_BLITCPU_ARMSIMD),
+#endif
+#if SDL_ARM_NEON_BLITTERS
+	SDL_BLIT_NAME(BlitARGBto565PixelAlphaARMNEON, SDL_BLITCPU_ARMNEON),
+	SDL_BLIT_NAME(BlitRGBtoRGBPixelAlphaARMNEON, SDL_BLITCPU_ARMNEON),
+#endif
+	SDL_BLIT_NAME(BlitNto1SurfaceAlpha, 0),
+	SDL_BLIT_NAME(BlitNto1PixelAlpha, 0),
+	SDL_BLIT_NAME(BlitNto1SurfaceAlphaKey, 0),
+	SDL_BLIT_NAME(BlitRGBtoRGBSurfaceAlpha, 0),
+	SDL_BLIT_NAME(BlitRGBtoRGBPixelAlpha, 0),
+	SDL_BLIT_NAME(Blit565to565SurfaceAlpha, 0),
+	SDL_BLIT_NAME(Blit555to555SurfaceAlpha, 0),
+	SDL_BLIT_NAME(BlitARGBto565PixelAlpha, 0),
+	SDL_BLIT_NAME(BlitARGBto555PixelAlpha, 0),
+	SDL_BLIT_NAME(BlitNtoNSurfaceAlpha, 0),
+	SDL_BLIT_NAME(BlitNtoNSurfaceAlphaKey, 0),
+	SDL_BLIT_NAME(BlitNtoNPixelAlpha, 0),
+	{ NULL, NULL, 0 }
+};
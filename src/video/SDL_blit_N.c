@@ -2617,3 +2617,41 @@ SDL_loblit SDL_CalculateBlitN(SDL_Surface *surface, int blit_index)
 
 	return(blitfun);
 }
+
+const SDL_BlitName SDL_BlitNamesN[] = {
+#if SDL_ALTIVEC_BLITTERS
+	SDL_BLIT_NAME(Blit_RGB888_RGB565Altivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(Blit_RGB565_32Altivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(Blit_RGB555_32Altivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(Blit32to32KeyAltivec, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(ConvertAltivec32to32_noprefetch, SDL_BLITCPU_ALTIVEC),
+	SDL_BLIT_NAME(ConvertAltivec32to32_prefetch, SDL_BLITCPU_ALTIVEC),
+#endif
+#if SDL_ARM_SIMD_BLITTERS
+	SDL_BLIT_NAME(Blit_BGR888_RGB888ARMSIMD, SDL_BLITCPU_ARMSIMD),
+	SDL_BLIT_NAME(Blit_RGB444_RGB888ARMSIMD, SDL_BLITCPU_ARMSIMD),
+#endif
+#if SDL_HERMES_BLITTERS
+	SDL_BLIT_NAME(ConvertMMX, SDL_BLITCPU_MMX),
+	SDL_BLIT_NAME(ConvertX86, 0),
+#else
+	SDL_BLIT_NAME(Blit_RGB888_index8, 0),
+	SDL_BLIT_NAME(Blit_RGB888_RGB555, 0),
+	SDL_BLIT_NAME(Blit_RGB888_RGB565, 0),
+#endif
+	SDL_BLIT_NAME(Blit_RGB565_ARGB8888, 0),
+	SDL_BLIT_NAME(Blit_RGB565_ABGR8888, 0),
+	SDL_BLIT_NAME(Blit_RGB565_RGBA8888, 0),
+	SDL_BLIT_NAME(Blit_RGB565_BGRA8888, 0),
+	SDL_BLIT_NAME(Blit_RGB888_index8_map, 0),
+	SDL_BLIT_NAME(BlitNto1, 0),
+	SDL_BLIT_NAME(Blit4to4MaskAlpha, 0),
+	SDL_BLIT_NAME(Blit4to4CopyAlpha, 0),
+	SDL_BLIT_NAME(BlitNtoN, 0),
+	SDL_BLIT_NAME(BlitNtoNCopyAlpha, 0),
+	SDL_BLIT_NAME(BlitNto1Key, 0),
+	SDL_BLIT_NAME(Blit2to2Key, 0),
+	SDL_BLIT_NAME(BlitNtoNKey, 0),
+	SDL_BLIT_NAME(BlitNtoNKeyCopyAlpha, 0),
+	{ NULL, NULL, 0 }
+};
@@ -30,6 +30,7 @@
 #include "SDL_sysvideo.h"
 #include "SDL_cursor_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_region_c.h"
 #include "default_cursor.h"
 #include "../events/SDL_sysevents.h"
 #include "../events/SDL_events_c.h"
@@ -643,8 +644,11 @@ void SDL_DrawCursor(SDL_Surface *screen)
 	if ( screen == NULL ) {
 		return;
 	}
+	/* The cursor area is updated below, it isn't damage */
+	SDL_HoldDamage(screen);
 	if ( SDL_MUSTLOCK(screen) ) {
 		if ( SDL_LockSurface(screen) < 0 ) {
+			SDL_ReleaseDamage(screen);
 			return;
 		}
 	}
@@ -655,6 +659,7 @@ void SDL_DrawCursor(SDL_Surface *screen)
 	if ( SDL_MUSTLOCK(screen) ) {
 		SDL_UnlockSurface(screen);
 	}
+	SDL_ReleaseDamage(screen);
 	if ( (screen == SDL_VideoSurface) &&
 	     ((screen->flags & SDL_HWSURFACE) != SDL_HWSURFACE) ) {
 		SDL_VideoDevice *video = current_video;
@@ -717,8 +722,11 @@ void SDL_EraseCursor(SDL_Surface *screen)
 	if ( screen == NULL ) {
 		return;
 	}
+	/* The cursor area is updated below, it isn't damage */
+	SDL_HoldDamage(screen);
 	if ( SDL_MUSTLOCK(screen) ) {
 		if ( SDL_LockSurface(screen) < 0 ) {
+			SDL_ReleaseDamage(screen);
 			return;
 		}
 	}
@@ -729,6 +737,7 @@ void SDL_EraseCursor(SDL_Surface *screen)
 	if ( SDL_MUSTLOCK(screen) ) {
 		SDL_UnlockSurface(screen);
 	}
+	SDL_ReleaseDamage(screen);
 	if ( (screen == SDL_VideoSurface) &&
 	     ((screen->flags & SDL_HWSURFACE) != SDL_HWSURFACE) ) {
 		SDL_VideoDevice *video = current_video;
@@ -576,7 +576,7 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 	/* Clear out any previous mapping */
 	map = src->map;
 	if ( (src->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
-		SDL_UnRLESurface(src, 1);
+		SDL_UnRLESurface(src, 2);
 	}
 	SDL_InvalidateMap(map);
 
@@ -599,6 +599,7 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 			}
 			if ( ! map->identity ) {
 				if ( map->table == NULL ) {
+					SDL_FreeRLECache(map);
 					return(-1);
 				}
 			}
@@ -610,6 +611,7 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 			/* Palette --> BitField */
 			map->table = Map1toN(srcfmt, dstfmt);
 			if ( map->table == NULL ) {
+				SDL_FreeRLECache(map);
 				return(-1);
 			}
 			break;
@@ -622,6 +624,7 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 			map->table = MapNto1(srcfmt, dstfmt, &map->identity);
 			if ( ! map->identity ) {
 				if ( map->table == NULL ) {
+					SDL_FreeRLECache(map);
 					return(-1);
 				}
 			}
@@ -646,6 +649,7 @@ void SDL_FreeBlitMap(SDL_BlitMap *map)
 {
 	if ( map ) {
 		SDL_InvalidateMap(map);
+		SDL_FreeRLECache(map);
 		if ( map->sw_data != NULL ) {
 			SDL_free(map->sw_data);
 		}
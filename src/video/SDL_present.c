@@ -0,0 +1,263 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Presenting the shadow surface on a background thread */
+
+#include "SDL_video.h"
+#include "SDL_thread.h"
+#include "SDL_sysvideo.h"
+#include "SDL_blit.h"
+#include "SDL_pixels_c.h"
+#include "SDL_cursor_c.h"
+#include "SDL_region_c.h"
+#include "SDL_present_c.h"
+
+#define PRESENT_IDLE	0
+#define PRESENT_PENDING	1
+#define PRESENT_QUIT	2
+
+static int SDLCALL SDL_PresentThread(void *data)
+{
+	SDL_VideoDevice *video = (SDL_VideoDevice *)data;
+	SDL_VideoDevice *this  = (SDL_VideoDevice *)data;
+	SDL_Surface *present = video->present;
+	SDL_Surface *screen;
+	SDL_Rect *rects;
+	int i, numrects;
+
+	SDL_mutexP(video->present_lock);
+	for ( ; ; ) {
+		while ( video->present_state == PRESENT_IDLE ) {
+			SDL_CondWait(video->present_cond, video->present_lock);
+		}
+		if ( video->present_state == PRESENT_QUIT ) {
+			break;
+		}
+		SDL_mutexV(video->present_lock);
+
+		/* The cursor lock keeps the cursor still and off the video
+		   surface while we draw it on the frame and convert it */
+		screen = SDL_VideoSurface;
+		rects = video->present_rects;
+		numrects = video->present_numrects;
+		SDL_LockCursor();
+		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+			SDL_DrawCursor(present);
+			for ( i=0; i<numrects; ++i ) {
+				SDL_LowerBlit(present, &rects[i], screen, &rects[i]);
+			}
+			SDL_EraseCursor(present);
+		} else {
+			for ( i=0; i<numrects; ++i ) {
+				SDL_LowerBlit(present, &rects[i], screen, &rects[i]);
+			}
+		}
+		if ( screen->offset ) {
+			for ( i=0; i<numrects; ++i ) {
+				rects[i].x += video->offset_x;
+				rects[i].y += video->offset_y;
+			}
+		}
+		video->UpdateRects(this, numrects, rects);
+		SDL_UnlockCursor();
+
+		SDL_mutexP(video->present_lock);
+		video->present_state = PRESENT_IDLE;
+		SDL_CondBroadcast(video->present_cond);
+	}
+	SDL_mutexV(video->present_lock);
+	return(0);
+}
+
+void SDL_StartPresent(SDL_VideoDevice *video)
+{
+	SDL_Surface *shadow = SDL_ShadowSurface;
+	const char *env;
+
+	/* The cursor code draws on the video surface without waiting for us,
+	   which is only safe as long as the video surface needn't be locked */
+	env = SDL_getenv("SDL_VIDEO_ASYNC_PRESENT");
+	if ( !env || !SDL_atoi(env) || !video->threaded_update ||
+	     !shadow || video->present_thread ||
+	     SDL_MUSTLOCK(SDL_VideoSurface) ||
+	     (SDL_VideoSurface->flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF ) {
+		return;
+	}
+
+	video->present = SDL_CreateRGBSurface(SDL_SWSURFACE,
+				shadow->w, shadow->h,
+				shadow->format->BitsPerPixel,
+				shadow->format->Rmask,
+				shadow->format->Gmask,
+				shadow->format->Bmask,
+				shadow->format->Amask);
+	video->present_lock = SDL_CreateMutex();
+	video->present_cond = SDL_CreateCond();
+	if ( !video->present || !video->present_lock || !video->present_cond ) {
+		SDL_StopPresent(video);
+		return;
+	}
+	if ( video->present->format->palette ) {
+		SDL_memcpy(video->present->format->palette->colors,
+		           shadow->format->palette->colors,
+		           shadow->format->palette->ncolors*sizeof(SDL_Color));
+	}
+	video->present_state = PRESENT_IDLE;
+	video->present_thread = SDL_CreateThread(SDL_PresentThread, video);
+	if ( !video->present_thread ) {
+		SDL_StopPresent(video);
+	}
+}
+
+void SDL_StopPresent(SDL_VideoDevice *video)
+{
+	if ( video->present_thread ) {
+		SDL_mutexP(video->present_lock);
+		while ( video->present_state != PRESENT_IDLE ) {
+			SDL_CondWait(video->present_cond, video->present_lock);
+		}
+		video->present_state = PRESENT_QUIT;
+		SDL_CondBroadcast(video->present_cond);
+		SDL_mutexV(video->present_lock);
+		SDL_WaitThread(video->present_thread, NULL);
+		video->present_thread = NULL;
+	}
+	if ( video->present_cond ) {
+		SDL_DestroyCond(video->present_cond);
+		video->present_cond = NULL;
+	}
+	if ( video->present_lock ) {
+		SDL_DestroyMutex(video->present_lock);
+		video->present_lock = NULL;
+	}
+	if ( video->present ) {
+		SDL_FreeSurface(video->present);
+		video->present = NULL;
+	}
+	if ( video->present_rects ) {
+		SDL_free(video->present_rects);
+		video->present_rects = NULL;
+	}
+	video->max_present_rects = 0;
+	video->present_numrects = 0;
+	video->present_state = PRESENT_IDLE;
+}
+
+void SDL_WaitPresent(SDL_VideoDevice *video)
+{
+	if ( !video || !video->present_thread ||
+	     SDL_ThreadID() == SDL_GetThreadID(video->present_thread) ) {
+		return;
+	}
+	SDL_mutexP(video->present_lock);
+	while ( video->present_state != PRESENT_IDLE ) {
+		SDL_CondWait(video->present_cond, video->present_lock);
+	}
+	SDL_mutexV(video->present_lock);
+}
+
+/* Bring the palette of the frame in line with the colors the shadow
+   surface would be converted with */
+static void SDL_PresentPalette(SDL_VideoDevice *video)
+{
+	SDL_Palette *pal = SDL_ShadowSurface->format->palette;
+	SDL_Palette *framepal = video->present->format->palette;
+	SDL_Color *colors;
+
+	colors = pal->colors;
+	if ( !(SDL_VideoSurface->flags & SDL_HWPALETTE) ) {
+		/* simulated 8bpp, use correct physical palette */
+		if ( video->gammacols ) {
+			colors = video->gammacols;
+		} else if ( video->physpal ) {
+			colors = video->physpal->colors;
+		}
+	}
+	if ( SDL_memcmp(framepal->colors, colors,
+	                framepal->ncolors*sizeof(SDL_Color)) != 0 ) {
+		SDL_memcpy(framepal->colors, colors,
+		           framepal->ncolors*sizeof(SDL_Color));
+		SDL_InvalidateMap(video->present->map);
+	}
+}
+
+void SDL_QueuePresent(SDL_VideoDevice *video,
+                      int numrects, const SDL_Rect *rects)
+{
+	SDL_Surface *shadow = SDL_ShadowSurface;
+	SDL_Surface *present = video->present;
+	int bpp = shadow->format->BytesPerPixel;
+	int i, w, h;
+	Uint8 *src, *dst;
+
+	/* Wait for the previous frame to be done with the buffer */
+	SDL_WaitPresent(video);
+
+	if ( numrects > video->max_present_rects ) {
+		SDL_Rect *new_rects;
+
+		new_rects = (SDL_Rect *)SDL_realloc(video->present_rects,
+		                                    numrects*sizeof(SDL_Rect));
+		if ( !new_rects ) {
+			SDL_OutOfMemory();
+			return;
+		}
+		video->present_rects = new_rects;
+		video->max_present_rects = numrects;
+	}
+	if ( present->format->palette ) {
+		SDL_PresentPalette(video);
+	}
+
+	/* Take a copy of the frame, so the app can go on drawing */
+	SDL_HoldDamage(shadow);
+	if ( SDL_MUSTLOCK(shadow) && SDL_LockSurface(shadow) < 0 ) {
+		SDL_ReleaseDamage(shadow);
+		return;
+	}
+	for ( i=0; i<numrects; ++i ) {
+		src = (Uint8 *)shadow->pixels + rects[i].y * shadow->pitch +
+		                                rects[i].x * bpp;
+		dst = (Uint8 *)present->pixels + rects[i].y * present->pitch +
+		                                 rects[i].x * bpp;
+		w = rects[i].w * bpp;
+		h = rects[i].h;
+		while ( h-- ) {
+			SDL_memcpy(dst, src, w);
+			src += shadow->pitch;
+			dst += present->pitch;
+		}
+		video->present_rects[i] = rects[i];
+	}
+	if ( SDL_MUSTLOCK(shadow) ) {
+		SDL_UnlockSurface(shadow);
+	}
+	SDL_ReleaseDamage(shadow);
+
+	/* Off it goes */
+	SDL_mutexP(video->present_lock);
+	video->present_numrects = numrects;
+	video->present_state = PRESENT_PENDING;
+	SDL_CondBroadcast(video->present_cond);
+	SDL_mutexV(video->present_lock);
+}
@@ -0,0 +1,52 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Presenting the shadow surface on a background thread.
+
+   When this is enabled, updating the shadow surface copies the rectangles
+   into a second buffer and returns, while a present thread converts that
+   buffer to the video surface and passes it on to the driver.  The app can
+   go on drawing the next frame into the shadow surface in the meantime.
+ */
+
+/* Starts the present thread for the current shadow surface, if the
+   SDL_VIDEO_ASYNC_PRESENT environment variable asks for it, the driver
+   allows its UpdateRects() to be called from another thread and the video
+   surface is a plain software surface.  If anything
+   goes wrong the shadow surface is simply presented synchronously.
+ */
+extern void SDL_StartPresent(SDL_VideoDevice *video);
+
+/* Waits for any present in progress and stops the present thread */
+extern void SDL_StopPresent(SDL_VideoDevice *video);
+
+/* Waits until the present thread is done with the video surface.  This is
+   a no-op when there is no present thread, or when called from it.
+ */
+extern void SDL_WaitPresent(SDL_VideoDevice *video);
+
+/* Hands the given shadow surface rectangles to the present thread,
+   waiting for the previous frame to finish first.
+ */
+extern void SDL_QueuePresent(SDL_VideoDevice *video,
+                             int numrects, const SDL_Rect *rects);
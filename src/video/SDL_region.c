@@ -0,0 +1,370 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Region handling for screen updates */
+
+#include "SDL_video.h"
+#include "SDL_sysvideo.h"
+#include "SDL_region_c.h"
+
+/* The fixed cost of updating one more rectangle, in pixels.  This covers
+   clipping and setting up the shadow blit, and the driver's overhead for
+   each rectangle it pushes to the display.
+ */
+#define RECT_COST	1024
+
+#define AREA(r)		((Uint32)(r)->w * (r)->h)
+
+static void UnionRect(const SDL_Rect *a, const SDL_Rect *b, SDL_Rect *u)
+{
+	int x1, y1, x2, y2;
+
+	x1 = SDL_min(a->x, b->x);
+	y1 = SDL_min(a->y, b->y);
+	x2 = SDL_max(a->x + a->w, b->x + b->w);
+	y2 = SDL_max(a->y + a->h, b->y + b->h);
+	u->x = x1;
+	u->y = y1;
+	u->w = x2 - x1;
+	u->h = y2 - y1;
+}
+
+static SDL_bool ClipRect(const SDL_Rect *r, const SDL_Rect *bounds, SDL_Rect *clipped)
+{
+	int x1, y1, x2, y2;
+
+	x1 = SDL_max(r->x, bounds->x);
+	y1 = SDL_max(r->y, bounds->y);
+	x2 = SDL_min(r->x + r->w, bounds->x + bounds->w);
+	y2 = SDL_min(r->y + r->h, bounds->y + bounds->h);
+	if ( x2 <= x1 || y2 <= y1 ) {
+		return(SDL_FALSE);
+	}
+	clipped->x = x1;
+	clipped->y = y1;
+	clipped->w = x2 - x1;
+	clipped->h = y2 - y1;
+	return(SDL_TRUE);
+}
+
+static Uint32 OverlapArea(const SDL_Rect *a, const SDL_Rect *b)
+{
+	int w, h;
+
+	w = SDL_min(a->x + a->w, b->x + b->w) - SDL_max(a->x, b->x);
+	h = SDL_min(a->y + a->h, b->y + b->h) - SDL_max(a->y, b->y);
+	if ( w <= 0 || h <= 0 ) {
+		return(0);
+	}
+	return((Uint32)w * h);
+}
+
+/* Cut 'a' out of 'b', which it overlaps, leaving up to 4 pieces */
+static int SubtractRect(const SDL_Rect *b, const SDL_Rect *a, SDL_Rect *pieces)
+{
+	int ax2 = a->x + a->w, ay2 = a->y + a->h;
+	int bx2 = b->x + b->w, by2 = b->y + b->h;
+	int y1, y2;
+	int n = 0;
+
+	/* Full width bands above and below */
+	if ( a->y > b->y ) {
+		pieces[n].x = b->x;
+		pieces[n].y = b->y;
+		pieces[n].w = b->w;
+		pieces[n].h = a->y - b->y;
+		++n;
+	}
+	if ( ay2 < by2 ) {
+		pieces[n].x = b->x;
+		pieces[n].y = ay2;
+		pieces[n].w = b->w;
+		pieces[n].h = by2 - ay2;
+		++n;
+	}
+
+	/* Whatever is left to the sides, in between */
+	y1 = SDL_max(a->y, b->y);
+	y2 = SDL_min(ay2, by2);
+	if ( a->x > b->x ) {
+		pieces[n].x = b->x;
+		pieces[n].y = y1;
+		pieces[n].w = a->x - b->x;
+		pieces[n].h = y2 - y1;
+		++n;
+	}
+	if ( ax2 < bx2 ) {
+		pieces[n].x = ax2;
+		pieces[n].y = y1;
+		pieces[n].w = bx2 - ax2;
+		pieces[n].h = y2 - y1;
+		++n;
+	}
+	return(n);
+}
+
+static int SDLCALL CompareTop(const void *a, const void *b)
+{
+	return(((const SDL_Rect *)a)->y - ((const SDL_Rect *)b)->y);
+}
+
+/* Drop the rectangles that were merged or split away */
+static int Compact(SDL_Rect *rects, int n)
+{
+	int i, m;
+
+	m = 0;
+	for ( i=0; i<n; ++i ) {
+		if ( rects[i].w ) {
+			rects[m++] = rects[i];
+		}
+	}
+	return(m);
+}
+
+int SDL_CoalesceRects(const SDL_Rect *rects, int numrects,
+                      const SDL_Rect *bounds, SDL_Rect *out, int maxout)
+{
+	SDL_Rect pieces[4];
+	SDL_Rect u;
+	int merged;
+	int i, j, k, n, sorted;
+
+	/* Clip, and drop anything that's left empty */
+	n = 0;
+	for ( i=0; i<numrects; ++i ) {
+		if ( ClipRect(&rects[i], bounds, &out[n]) ) {
+			++n;
+		}
+	}
+
+	/* Merge pairs that cost less to update in one go than separately.
+	   This takes care of duplicates and contained rectangles as well.
+	   With the rectangles sorted by their top edge, merging never moves
+	   one, and the search can stop once the gap below the current one
+	   alone wastes more than a rectangle costs.  Merged rectangles are
+	   emptied and dropped at the end of each pass.
+	 */
+	SDL_qsort(out, n, sizeof(*out), CompareTop);
+	do {
+		merged = 0;
+		for ( i=0; i<n; ++i ) {
+			if ( !out[i].w ) {
+				continue;
+			}
+			for ( j=i+1; j<n; ++j ) {
+				int gap = out[j].y - (out[i].y + out[i].h);
+				if ( gap > 0 && (Uint32)gap * out[i].w > RECT_COST ) {
+					break;
+				}
+				if ( !out[j].w ) {
+					continue;
+				}
+				gap = SDL_max(out[i].x, out[j].x) -
+				      SDL_min(out[i].x + out[i].w, out[j].x + out[j].w);
+				if ( gap > 0 && (Uint32)gap * out[i].h > RECT_COST ) {
+					continue;
+				}
+				UnionRect(&out[i], &out[j], &u);
+				if ( AREA(&u) <= AREA(&out[i]) + AREA(&out[j]) + RECT_COST ) {
+					out[i] = u;
+					out[j].w = 0;
+					merged = 1;
+					j = i;	/* it grew, look again */
+				}
+			}
+		}
+		n = Compact(out, n);
+	} while ( merged );
+
+	/* Split whatever still overlaps, if that copies enough less to pay
+	   for the extra rectangles.  Once a rectangle has been through the
+	   outer loop, none of the ones after it overlap it any more.  The
+	   pieces go at the end, so the sorted part stays sorted.
+	 */
+	sorted = n;
+	for ( i=0; i<n; ++i ) {
+		if ( !out[i].w ) {
+			continue;
+		}
+		for ( j=i+1; j<n; ++j ) {
+			Uint32 overlap;
+
+			if ( j < sorted && out[j].y >= out[i].y + out[i].h ) {
+				j = sorted - 1;	/* skip to the pieces */
+				continue;
+			}
+			if ( !out[j].w ) {
+				continue;
+			}
+			overlap = OverlapArea(&out[i], &out[j]);
+			if ( !overlap ) {
+				continue;
+			}
+			k = SubtractRect(&out[j], &out[i], pieces);
+			if ( k > 0 && (overlap <= (Uint32)(k - 1) * RECT_COST ||
+			               n + k > maxout) ) {
+				continue;
+			}
+			out[j].w = 0;
+			while ( k-- > 0 ) {
+				out[n++] = pieces[k];
+			}
+		}
+	}
+	return(Compact(out, n));
+}
+
+int SDL_AllocDamage(SDL_VideoDevice *video, int w, int h)
+{
+	int cols, rows;
+
+	SDL_FreeDamage(video);
+
+	cols = (w + SDL_DAMAGE_TILE - 1) >> SDL_DAMAGE_TILE_BITS;
+	rows = (h + SDL_DAMAGE_TILE - 1) >> SDL_DAMAGE_TILE_BITS;
+	video->damage = (Uint8 *)SDL_malloc(cols * rows);
+	/* At most one rectangle for every other tile in a row */
+	video->damage_rects = (SDL_Rect *)SDL_malloc(
+	                     (cols / 2 + 1) * rows * sizeof(SDL_Rect));
+	if ( !video->damage || !video->damage_rects ) {
+		SDL_FreeDamage(video);
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	video->damage_cols = cols;
+	video->damage_rows = rows;
+	video->damage_hold = 0;
+
+	/* Nothing is known to be on the screen yet */
+	SDL_memset(video->damage, 1, cols * rows);
+	return(0);
+}
+
+void SDL_FreeDamage(SDL_VideoDevice *video)
+{
+	if ( video->damage ) {
+		SDL_free(video->damage);
+		video->damage = NULL;
+	}
+	if ( video->damage_rects ) {
+		SDL_free(video->damage_rects);
+		video->damage_rects = NULL;
+	}
+	video->damage_cols = 0;
+	video->damage_rows = 0;
+}
+
+void SDL_DamageRect(SDL_Surface *surface, const SDL_Rect *rect)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_Rect bounds, r;
+	Uint8 *row;
+	int x1, y1, x2, y2;
+
+	if ( !video || !video->damage || surface != SDL_PublicSurface ) {
+		return;
+	}
+	bounds.x = 0;
+	bounds.y = 0;
+	bounds.w = surface->w;
+	bounds.h = surface->h;
+	if ( !rect ) {
+		rect = &bounds;
+	}
+	if ( !ClipRect(rect, &bounds, &r) ) {
+		return;
+	}
+
+	x1 = r.x >> SDL_DAMAGE_TILE_BITS;
+	y1 = r.y >> SDL_DAMAGE_TILE_BITS;
+	x2 = (r.x + r.w - 1) >> SDL_DAMAGE_TILE_BITS;
+	y2 = (r.y + r.h - 1) >> SDL_DAMAGE_TILE_BITS;
+	row = video->damage + y1 * video->damage_cols + x1;
+	for ( ; y1 <= y2; ++y1 ) {
+		SDL_memset(row, 1, x2 - x1 + 1);
+		row += video->damage_cols;
+	}
+}
+
+void SDL_DamageLocked(SDL_Surface *surface)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( video && !video->damage_hold ) {
+		SDL_DamageRect(surface, NULL);
+	}
+}
+
+void SDL_HoldDamage(SDL_Surface *surface)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( video && video->damage && surface == SDL_PublicSurface ) {
+		++video->damage_hold;
+	}
+}
+
+void SDL_ReleaseDamage(SDL_Surface *surface)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( video && video->damage && surface == SDL_PublicSurface ) {
+		--video->damage_hold;
+	}
+}
+
+int SDL_CollectDamage(SDL_VideoDevice *video, SDL_Rect **rects)
+{
+	SDL_Surface *screen = SDL_PublicSurface;
+	Uint8 *row = video->damage;
+	int x, y, start, n;
+
+	/* One rectangle for each run of damaged tiles in a row; runs that
+	   line up in consecutive rows are merged by SDL_UpdateRects() */
+	n = 0;
+	for ( y=0; y<video->damage_rows; ++y ) {
+		x = 0;
+		while ( x < video->damage_cols ) {
+			if ( !row[x] ) {
+				++x;
+				continue;
+			}
+			start = x;
+			while ( x < video->damage_cols && row[x] ) {
+				++x;
+			}
+			video->damage_rects[n].x = start << SDL_DAMAGE_TILE_BITS;
+			video->damage_rects[n].y = y << SDL_DAMAGE_TILE_BITS;
+			video->damage_rects[n].w = SDL_min(x << SDL_DAMAGE_TILE_BITS,
+			                                   screen->w) - video->damage_rects[n].x;
+			video->damage_rects[n].h = SDL_min((y + 1) << SDL_DAMAGE_TILE_BITS,
+			                                   screen->h) - video->damage_rects[n].y;
+			++n;
+		}
+		SDL_memset(row, 0, video->damage_cols);
+		row += video->damage_cols;
+	}
+	*rects = video->damage_rects;
+	return(n);
+}
@@ -0,0 +1,64 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2012 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Useful functions for working with screen update regions */
+
+/* Replace a list of update rectangles with a cheaper list covering at least
+   the same pixels: rectangles are clipped to 'bounds', duplicates and
+   rectangles that are close enough together are merged, and overlapping
+   ones are split so no pixel is updated twice.  'out' must have room for
+   'maxout' rectangles, at least 'numrects'; more room allows more splits.
+   Returns the number of rectangles written to 'out'.
+ */
+extern int SDL_CoalesceRects(const SDL_Rect *rects, int numrects,
+                             const SDL_Rect *bounds,
+                             SDL_Rect *out, int maxout);
+
+/* Damage tracking on the display surface, see SDL_SetDamageTracking().
+   The screen is split into square tiles, and a map of the tiles written
+   to since the last update is kept on the video device.
+ */
+#define SDL_DAMAGE_TILE_BITS	5
+#define SDL_DAMAGE_TILE		(1 << SDL_DAMAGE_TILE_BITS)
+
+/* Start or stop tracking damage on a w x h screen */
+extern int SDL_AllocDamage(SDL_VideoDevice *video, int w, int h);
+extern void SDL_FreeDamage(SDL_VideoDevice *video);
+
+/* Record a write to the given part of a surface, or all of it if 'rect'
+   is NULL.  This does nothing unless the surface is the tracked screen.
+ */
+extern void SDL_DamageRect(SDL_Surface *surface, const SDL_Rect *rect);
+
+/* Record that the surface was locked, so the application may have written
+   anywhere on it.  Operations that record their own damage hold it while
+   they lock the surface, so that doesn't count.
+ */
+extern void SDL_DamageLocked(SDL_Surface *surface);
+extern void SDL_HoldDamage(SDL_Surface *surface);
+extern void SDL_ReleaseDamage(SDL_Surface *surface);
+
+/* Get the damaged parts of the screen as rectangles, in the scratch space
+   of the damage map, and start over with an undamaged screen.
+ */
+extern int SDL_CollectDamage(SDL_VideoDevice *video, SDL_Rect **rects);
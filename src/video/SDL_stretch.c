@@ -28,176 +28,70 @@
 */
 
 #include "SDL_video.h"
+#include "SDL_sysvideo.h"
 #include "SDL_blit.h"
+#include "SDL_region_c.h"
+#include "SDL_cpuinfo.h"
 
 /* This isn't ready for general consumption yet - it should be folded
    into the general blitting mechanism.
 */
 
-#if ((defined(_MSC_VER) && defined(_M_IX86)) || \
-     (defined(__WATCOMC__) && defined(__386__)) || \
-     (defined(__GNUC__) && defined(__i386__))) && SDL_ASSEMBLY_ROUTINES
-/* There's a bug with gcc 4.4.1 and -O2 where srcp doesn't get the correct
- * value after the first scanline.  FIXME? */
-/*#define USE_ASM_STRETCH*/
-#endif
-
-#ifdef USE_ASM_STRETCH
-
-#ifdef HAVE_MPROTECT
-#include <sys/types.h>
-#include <sys/mman.h>
-#endif
-#ifdef __GNUC__
-#define PAGE_ALIGNED __attribute__((__aligned__(4096)))
-#else
-#define PAGE_ALIGNED
-#endif
-
-#if defined(_M_IX86) || defined(__i386__) || defined(__386__)
-#define PREFIX16	0x66
-#define STORE_BYTE	0xAA
-#define STORE_WORD	0xAB
-#define LOAD_BYTE	0xAC
-#define LOAD_WORD	0xAD
-#define RETURN		0xC3
-#else
-#error Need assembly opcodes for this architecture
-#endif
-
-static unsigned char copy_row[4096] PAGE_ALIGNED;
+/* The horizontal scaling is driven by a table of source pixel offsets,
+   one per destination pixel, built once per stretch and shared by every
+   row.  This replaces the old x86 code generator, which wrote a row copy
+   routine into a static buffer: that wasn't thread-safe and couldn't run
+   on systems that refuse writable executable memory.
+*/
 
-static int generate_rowbytes(int src_w, int dst_w, int bpp)
+/* Fill in the source pixel index for each destination pixel */
+static void SDL_StretchTable(int src_w, int dst_w, int *table)
 {
-	static struct {
-		int bpp;
-		int src_w;
-		int dst_w;
-		int status;
-	} last;
-
 	int i;
 	int pos, inc;
-	unsigned char *eip, *fence;
-	unsigned char load, store;
-
-	/* See if we need to regenerate the copy buffer */
-	if ( (src_w == last.src_w) &&
-	     (dst_w == last.dst_w) && (bpp == last.bpp) ) {
-		return(last.status);
-	}
-	last.bpp = bpp;
-	last.src_w = src_w;
-	last.dst_w = dst_w;
-	last.status = -1;
-
-	switch (bpp) {
-	    case 1:
-		load = LOAD_BYTE;
-		store = STORE_BYTE;
-		break;
-	    case 2:
-	    case 4:
-		load = LOAD_WORD;
-		store = STORE_WORD;
-		break;
-	    default:
-		SDL_SetError("ASM stretch of %d bytes isn't supported\n", bpp);
-		return(-1);
-	}
-#ifdef HAVE_MPROTECT
-	/* Make the code writeable */
-	if ( mprotect(copy_row, sizeof(copy_row), PROT_READ|PROT_WRITE) < 0 ) {
-		SDL_SetError("Couldn't make copy buffer writeable");
-		return(-1);
-	}
-#endif
-	pos = 0x10000;
+
+	pos = 0;
 	inc = (src_w << 16) / dst_w;
-	eip = copy_row;
-	fence = copy_row+sizeof(copy_row)-2;
 	for ( i=0; i<dst_w; ++i ) {
-		while ( pos >= 0x10000L ) {
-			if ( eip == fence ) {
-				return -1;
-			}
-			if ( bpp == 2 ) {
-				*eip++ = PREFIX16;
-			}
-			*eip++ = load;
-			pos -= 0x10000L;
-		}
-		if ( eip == fence ) {
-			return -1;
-		}
-		if ( bpp == 2 ) {
-			*eip++ = PREFIX16;
-		}
-		*eip++ = store;
+		table[i] = (pos >> 16);
 		pos += inc;
 	}
-	*eip++ = RETURN;
-
-#ifdef HAVE_MPROTECT
-	/* Make the code executable but not writeable */
-	if ( mprotect(copy_row, sizeof(copy_row), PROT_READ|PROT_EXEC) < 0 ) {
-		SDL_SetError("Couldn't make copy buffer executable");
-		return(-1);
-	}
-#endif
-	last.status = 0;
-	return(0);
 }
 
-#endif /* USE_ASM_STRETCH */
-
-#define DEFINE_COPY_ROW(name, type)			\
-void name(type *src, int src_w, type *dst, int dst_w)	\
-{							\
-	int i;						\
-	int pos, inc;					\
-	type pixel = 0;					\
-							\
-	pos = 0x10000;					\
-	inc = (src_w << 16) / dst_w;			\
-	for ( i=dst_w; i>0; --i ) {			\
-		while ( pos >= 0x10000L ) {		\
-			pixel = *src++;			\
-			pos -= 0x10000L;		\
-		}					\
-		*dst++ = pixel;				\
-		pos += inc;				\
-	}						\
+#define DEFINE_COPY_ROW(name, type)					\
+static void name(const type *src, type *dst, int dst_w, const int *table) \
+{									\
+	int i;								\
+									\
+	for ( i=0; i+4<=dst_w; i+=4 ) {					\
+		dst[i+0] = src[table[i+0]];				\
+		dst[i+1] = src[table[i+1]];				\
+		dst[i+2] = src[table[i+2]];				\
+		dst[i+3] = src[table[i+3]];				\
+	}								\
+	for ( ; i<dst_w; ++i ) {					\
+		dst[i] = src[table[i]];					\
+	}								\
 }
 DEFINE_COPY_ROW(copy_row1, Uint8)
 DEFINE_COPY_ROW(copy_row2, Uint16)
 DEFINE_COPY_ROW(copy_row4, Uint32)
 
-/* The ASM code doesn't handle 24-bpp stretch blits */
-void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
+static void copy_row3(const Uint8 *src, Uint8 *dst, int dst_w, const int *table)
 {
 	int i;
-	int pos, inc;
-	Uint8 pixel[3] = { 0, 0, 0 };
 
-	pos = 0x10000;
-	inc = (src_w << 16) / dst_w;
-	for ( i=dst_w; i>0; --i ) {
-		while ( pos >= 0x10000L ) {
-			pixel[0] = *src++;
-			pixel[1] = *src++;
-			pixel[2] = *src++;
-			pos -= 0x10000L;
-		}
+	for ( i=0; i<dst_w; ++i ) {
+		const Uint8 *pixel = src + table[i]*3;
 		*dst++ = pixel[0];
 		*dst++ = pixel[1];
 		*dst++ = pixel[2];
-		pos += inc;
 	}
 }
 
 /* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
+   The surfaces are locked, so this may be called from several threads
+   as long as they don't write to the same surface.
 */
 int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                     SDL_Surface *dst, SDL_Rect *dstrect)
@@ -207,16 +101,13 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	int pos, inc;
 	int dst_maxrow;
 	int src_row, dst_row;
+	int last_row;
+	int *table;
 	Uint8 *srcp = NULL;
 	Uint8 *dstp;
+	Uint8 *lastp = NULL;
 	SDL_Rect full_src;
 	SDL_Rect full_dst;
-#ifdef USE_ASM_STRETCH
-	SDL_bool use_asm = SDL_TRUE;
-#ifdef __GNUC__
-	int u1, u2;
-#endif
-#endif /* USE_ASM_STRETCH */
 	const int bpp = dst->format->BytesPerPixel;
 
 	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
@@ -253,11 +144,31 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		full_dst.h = dst->h;
 		dstrect = &full_dst;
 	}
+	if ( !srcrect->w || !srcrect->h || !dstrect->w || !dstrect->h ) {
+		return(0);
+	}
+
+	/* Build the horizontal step table, unless it's a plain copy */
+	table = NULL;
+	if ( srcrect->w != dstrect->w ) {
+		table = (int *)SDL_malloc(dstrect->w * sizeof(*table));
+		if ( table == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		SDL_StretchTable(srcrect->w, dstrect->w, table);
+	}
+
+	/* Record the damage, so locking the screen doesn't count as such */
+	SDL_DamageRect(dst, dstrect);
+	SDL_HoldDamage(dst);
 
 	/* Lock the destination if it's in hardware */
 	dst_locked = 0;
 	if ( SDL_MUSTLOCK(dst) ) {
 		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_free(table);
+			SDL_ReleaseDamage(dst);
 			SDL_SetError("Unable to lock destination surface");
 			return(-1);
 		}
@@ -270,6 +181,8 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 			if ( dst_locked ) {
 				SDL_UnlockSurface(dst);
 			}
+			SDL_free(table);
+			SDL_ReleaseDamage(dst);
 			SDL_SetError("Unable to lock source surface");
 			return(-1);
 		}
@@ -281,14 +194,7 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	inc = (srcrect->h << 16) / dstrect->h;
 	src_row = srcrect->y;
 	dst_row = dstrect->y;
-
-#ifdef USE_ASM_STRETCH
-	/* Write the opcodes for this stretch */
-	if ( (bpp == 3) ||
-	     (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0) ) {
-		use_asm = SDL_FALSE;
-	}
-#endif
+	last_row = -1;
 
 	/* Perform the stretch blit */
 	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
@@ -300,50 +206,36 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 			++src_row;
 			pos -= 0x10000L;
 		}
-#ifdef USE_ASM_STRETCH
-		if (use_asm) {
-#ifdef __GNUC__
-			__asm__ __volatile__ (
-			"call *%4"
-			: "=&D" (u1), "=&S" (u2)
-			: "0" (dstp), "1" (srcp), "r" (copy_row)
-			: "memory" );
-#elif defined(_MSC_VER) || defined(__WATCOMC__)
-		{ void *code = copy_row;
-			__asm {
-				push edi
-				push esi
-	
-				mov edi, dstp
-				mov esi, srcp
-				call dword ptr code
-
-				pop esi
-				pop edi
-			}
+		pos += inc;
+
+		/* Enlarging repeats source rows, copy the one already done */
+		if ( src_row == last_row ) {
+			SDL_memcpy(dstp, lastp, dstrect->w*bpp);
+			continue;
+		}
+		last_row = src_row;
+		lastp = dstp;
+
+		if ( !table ) {
+			SDL_memcpy(dstp, srcp, dstrect->w*bpp);
+			continue;
 		}
-#else
-#error Need inline assembly for this compiler
-#endif
-		} else
-#endif
 		switch (bpp) {
 		    case 1:
-			copy_row1(srcp, srcrect->w, dstp, dstrect->w);
+			copy_row1(srcp, dstp, dstrect->w, table);
 			break;
 		    case 2:
-			copy_row2((Uint16 *)srcp, srcrect->w,
-			          (Uint16 *)dstp, dstrect->w);
+			copy_row2((Uint16 *)srcp, (Uint16 *)dstp,
+			          dstrect->w, table);
 			break;
 		    case 3:
-			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
+			copy_row3(srcp, dstp, dstrect->w, table);
 			break;
 		    case 4:
-			copy_row4((Uint32 *)srcp, srcrect->w,
-			          (Uint32 *)dstp, dstrect->w);
+			copy_row4((Uint32 *)srcp, (Uint32 *)dstp,
+			          dstrect->w, table);
 			break;
 		}
-		pos += inc;
 	}
 
 	/* We need to unlock the surfaces if they're locked */
@@ -353,6 +245,552 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	if ( src_locked ) {
 		SDL_UnlockSurface(src);
 	}
+	SDL_ReleaseDamage(dst);
+	SDL_free(table);
 	return(0);
 }
 
+/* Filtered stretching.
+   The source is resampled one destination row at a time: a vertical pass
+   combines the needed source rows into a single row of source width, then
+   a horizontal pass resamples that row to the destination width.  Rows are
+   kept as 32-bit pixels with 8 bits per channel, so surfaces of the same
+   8888 format are filtered in place and everything else is unpacked to
+   ARGB8888 and packed back into the destination format on the way.
+
+   All the state lives on the stack or in a buffer allocated per call.
+*/
+
+#if SDL_ASSEMBLY_ROUTINES
+#if defined(__SSE2__) || (defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))))
+#define SSE2_STRETCH
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#define NEON_STRETCH
+#include <arm_neon.h>
+#endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+/* Interpolation weights have 7 bits of precision, this keeps the products
+   of two 8-bit channels within 16 bits for the packed and SIMD code. */
+#define STRETCH_FRAC_BITS	7
+#define STRETCH_FRAC_ONE	(1 << STRETCH_FRAC_BITS)
+
+enum {
+	STRETCH_STEP_NEAREST,
+	STRETCH_STEP_LINEAR,
+	STRETCH_STEP_AREA
+};
+
+/* One destination column or row: for nearest sampling only i0 is used,
+   for linear sampling w is the weight of i1 against i0, and for area
+   sampling [i0, i1) is the span of source pixels to average. */
+typedef struct {
+	int i0;
+	int i1;
+	int w;
+} SDL_StretchStep;
+
+static int SDL_StretchStepMode(SDL_StretchFilter filter, int src_len, int dst_len)
+{
+	switch (filter) {
+	    case SDL_STRETCH_AREA:
+		if ( dst_len < src_len ) {
+			return STRETCH_STEP_AREA;
+		}
+		/* Fall through, enlarging is better served by interpolation */
+	    case SDL_STRETCH_BILINEAR:
+		return STRETCH_STEP_LINEAR;
+	    default:
+		return STRETCH_STEP_NEAREST;
+	}
+}
+
+static void SDL_StretchSteps(int mode, int src_len, int dst_len,
+                             SDL_StretchStep *steps)
+{
+	int i;
+	int pos, inc;
+
+	/* Sample at pixel centers in 16.16 fixed point */
+	inc = (src_len << 16) / dst_len;
+	switch (mode) {
+	    case STRETCH_STEP_AREA:
+		for ( i = 0; i < dst_len; ++i ) {
+			steps[i].i0 = (i * src_len) / dst_len;
+			steps[i].i1 = ((i + 1) * src_len) / dst_len;
+			if ( steps[i].i1 <= steps[i].i0 ) {
+				steps[i].i1 = steps[i].i0 + 1;
+			}
+			steps[i].w = 0;
+		}
+		break;
+	    case STRETCH_STEP_LINEAR:
+		pos = (inc >> 1) - 0x8000;
+		for ( i = 0; i < dst_len; ++i, pos += inc ) {
+			if ( pos <= 0 ) {
+				steps[i].i0 = 0;
+				steps[i].w = 0;
+			} else {
+				steps[i].i0 = (pos >> 16);
+				steps[i].w = (pos >> (16 - STRETCH_FRAC_BITS)) &
+				             (STRETCH_FRAC_ONE - 1);
+			}
+			if ( steps[i].i0 >= src_len - 1 ) {
+				steps[i].i0 = src_len - 1;
+				steps[i].w = 0;
+			}
+			steps[i].i1 = steps[i].i0;
+			if ( steps[i].w ) {
+				++steps[i].i1;
+			}
+		}
+		break;
+	    default:
+		pos = (inc >> 1);
+		for ( i = 0; i < dst_len; ++i, pos += inc ) {
+			steps[i].i0 = (pos >> 16);
+			if ( steps[i].i0 >= src_len ) {
+				steps[i].i0 = src_len - 1;
+			}
+			steps[i].i1 = steps[i].i0;
+			steps[i].w = 0;
+		}
+		break;
+	}
+}
+
+/* Blend each 8-bit channel of two pixels, w is the weight of b */
+static __inline__ Uint32 SDL_StretchLerp(Uint32 a, Uint32 b, int w)
+{
+	Uint32 rb, ag;
+	const Uint32 iw = STRETCH_FRAC_ONE - w;
+
+	rb = ((a & 0x00FF00FF) * iw + (b & 0x00FF00FF) * w) >> STRETCH_FRAC_BITS;
+	ag = (((a >> 8) & 0x00FF00FF) * iw + ((b >> 8) & 0x00FF00FF) * w)
+	     << (8 - STRETCH_FRAC_BITS);
+	return (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+}
+
+static void SDL_StretchLerpRow(const Uint32 *a, const Uint32 *b,
+                               Uint32 *dst, int width, int w)
+{
+	int i = 0;
+#ifdef SSE2_STRETCH
+	if ( SDL_HasSSE2() ) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i wb = _mm_set1_epi16((short)w);
+		const __m128i wa = _mm_set1_epi16((short)(STRETCH_FRAC_ONE - w));
+		for ( ; i + 4 <= width; i += 4 ) {
+			__m128i pa = _mm_loadu_si128((const __m128i *)(a + i));
+			__m128i pb = _mm_loadu_si128((const __m128i *)(b + i));
+			__m128i lo = _mm_add_epi16(
+				_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), wa),
+				_mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), wb));
+			__m128i hi = _mm_add_epi16(
+				_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), wa),
+				_mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), wb));
+			lo = _mm_srli_epi16(lo, STRETCH_FRAC_BITS);
+			hi = _mm_srli_epi16(hi, STRETCH_FRAC_BITS);
+			_mm_storeu_si128((__m128i *)(dst + i),
+			                 _mm_packus_epi16(lo, hi));
+		}
+	}
+#elif defined(NEON_STRETCH)
+	if ( SDL_HasARMNEON() ) {
+		const uint8x8_t wb = vdup_n_u8((uint8_t)w);
+		const uint8x8_t wa = vdup_n_u8((uint8_t)(STRETCH_FRAC_ONE - w));
+		for ( ; i + 4 <= width; i += 4 ) {
+			uint8x16_t pa = vld1q_u8((const uint8_t *)(a + i));
+			uint8x16_t pb = vld1q_u8((const uint8_t *)(b + i));
+			uint16x8_t lo = vmull_u8(vget_low_u8(pa), wa);
+			uint16x8_t hi = vmull_u8(vget_high_u8(pa), wa);
+			lo = vmlal_u8(lo, vget_low_u8(pb), wb);
+			hi = vmlal_u8(hi, vget_high_u8(pb), wb);
+			vst1q_u8((uint8_t *)(dst + i),
+			         vcombine_u8(vshrn_n_u16(lo, STRETCH_FRAC_BITS),
+			                     vshrn_n_u16(hi, STRETCH_FRAC_BITS)));
+		}
+	}
+#endif
+	for ( ; i < width; ++i ) {
+		dst[i] = SDL_StretchLerp(a[i], b[i], w);
+	}
+}
+
+/* Add the channels of a row of pixels to a row of per-channel sums */
+static void SDL_StretchAccumulateRow(const Uint32 *src, Uint32 *sums, int width)
+{
+	int i = 0;
+#ifdef SSE2_STRETCH
+	/* The sums are kept in memory byte order, which is the same as
+	   the channel order of the scalar code on little endian x86. */
+	if ( SDL_HasSSE2() ) {
+		const __m128i zero = _mm_setzero_si128();
+		for ( ; i + 4 <= width; i += 4 ) {
+			__m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i lo = _mm_unpacklo_epi8(p, zero);
+			__m128i hi = _mm_unpackhi_epi8(p, zero);
+			__m128i *s = (__m128i *)(sums + i * 4);
+			_mm_storeu_si128(s + 0, _mm_add_epi32(_mm_loadu_si128(s + 0), _mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+		}
+	}
+#endif
+	for ( ; i < width; ++i ) {
+		const Uint32 p = src[i];
+		Uint32 *s = sums + i * 4;
+		s[0] += (p & 0xFF);
+		s[1] += ((p >> 8) & 0xFF);
+		s[2] += ((p >> 16) & 0xFF);
+		s[3] += (p >> 24);
+	}
+}
+
+static __inline__ Uint32 SDL_StretchAverage(const Uint32 *sums, Uint32 count)
+{
+	const Uint32 half = count / 2;
+
+	return (((sums[0] + half) / count)) |
+	       (((sums[1] + half) / count) << 8) |
+	       (((sums[2] + half) / count) << 16) |
+	       (((sums[3] + half) / count) << 24);
+}
+
+/* Convert a row of pixels to ARGB8888 */
+static void SDL_StretchUnpackRow(const Uint8 *src, SDL_PixelFormat *fmt,
+                                 Uint32 *dst, int width)
+{
+	const int bpp = fmt->BytesPerPixel;
+	Uint32 Pixel;
+	unsigned r, g, b, a;
+	int i;
+
+	for ( i = 0; i < width; ++i, src += bpp ) {
+		switch (bpp) {
+		    case 2:
+			Pixel = *((const Uint16 *)src);
+			break;
+		    case 3:
+			if ( SDL_BYTEORDER == SDL_LIL_ENDIAN ) {
+				Pixel = src[0] | (src[1] << 8) | (src[2] << 16);
+			} else {
+				Pixel = (src[0] << 16) | (src[1] << 8) | src[2];
+			}
+			break;
+		    default:
+			Pixel = *((const Uint32 *)src);
+			break;
+		}
+		RGBA_FROM_PIXEL(Pixel, fmt, r, g, b, a);
+		if ( !fmt->Amask ) {
+			a = 0xFF;
+		}
+		dst[i] = (a << 24) | (r << 16) | (g << 8) | b;
+	}
+}
+
+/* Convert a row of ARGB8888 pixels to the destination format */
+static void SDL_StretchPackRow(const Uint32 *src, Uint8 *dst,
+                               SDL_PixelFormat *fmt, int width)
+{
+	const int bpp = fmt->BytesPerPixel;
+	unsigned r, g, b, a;
+	int i;
+
+	for ( i = 0; i < width; ++i, dst += bpp ) {
+		a = (src[i] >> 24);
+		r = (src[i] >> 16) & 0xFF;
+		g = (src[i] >> 8) & 0xFF;
+		b = (src[i] & 0xFF);
+		ASSEMBLE_RGBA(dst, bpp, fmt, r, g, b, a);
+	}
+}
+
+/* Get a source row as 32-bit pixels, unpacking it into one of the two
+   row buffers unless it's already there.  The buffer in slot 'keep' is
+   still in use and won't be replaced. */
+static const Uint32 *SDL_StretchFetchRow(SDL_Surface *src, SDL_Rect *srcrect,
+                                         int direct, Uint32 **rows,
+                                         int *cached, int row, int keep)
+{
+	const Uint8 *srcp;
+	int slot;
+
+	srcp = (const Uint8 *)src->pixels + ((srcrect->y + row) * src->pitch)
+	                                  + (srcrect->x * src->format->BytesPerPixel);
+	if ( direct ) {
+		return (const Uint32 *)srcp;
+	}
+	if ( cached[0] == row ) {
+		return rows[0];
+	}
+	if ( cached[1] == row ) {
+		return rows[1];
+	}
+	if ( keep >= 0 ) {
+		slot = !keep;
+	} else {
+		/* Rows are visited top to bottom, replace the oldest one */
+		slot = (cached[0] <= cached[1]) ? 0 : 1;
+	}
+	SDL_StretchUnpackRow(srcp, src->format, rows[slot], srcrect->w);
+	cached[slot] = row;
+	return rows[slot];
+}
+
+static int SDL_StretchDirect8888(SDL_PixelFormat *src, SDL_PixelFormat *dst)
+{
+	return (src->BytesPerPixel == 4 && dst->BytesPerPixel == 4 &&
+	        src->Rmask == dst->Rmask && src->Gmask == dst->Gmask &&
+	        src->Bmask == dst->Bmask && src->Amask == dst->Amask &&
+	        src->Rloss == 0 && src->Gloss == 0 && src->Bloss == 0 &&
+	        (src->Amask == 0 || src->Aloss == 0));
+}
+
+/* See if pixels can be copied from one format to the other as they are */
+static SDL_bool SDL_StretchSameFormat(SDL_PixelFormat *src,
+                                      SDL_PixelFormat *dst)
+{
+	if ( (src->BitsPerPixel != dst->BitsPerPixel) ||
+	     (src->Rmask != dst->Rmask) || (src->Gmask != dst->Gmask) ||
+	     (src->Bmask != dst->Bmask) || (src->Amask != dst->Amask) ) {
+		return(SDL_FALSE);
+	}
+	if ( src->palette || dst->palette ) {
+		if ( !src->palette || !dst->palette ||
+		     (src->palette->ncolors != dst->palette->ncolors) ||
+		     (SDL_memcmp(src->palette->colors, dst->palette->colors,
+		                 src->palette->ncolors*sizeof(SDL_Color)) != 0) ) {
+			return(SDL_FALSE);
+		}
+	}
+	return(SDL_TRUE);
+}
+
+int SDL_SoftStretchFilter(SDL_Surface *src, SDL_Rect *srcrect,
+                          SDL_Surface *dst, SDL_Rect *dstrect,
+                          SDL_StretchFilter filter)
+{
+	int src_locked;
+	int dst_locked;
+	int direct;
+	int hmode, vmode;
+	int src_w, src_h, dst_w, dst_h;
+	int x, y, i;
+	int cached[2];
+	Uint8 *buffer;
+	SDL_StretchStep *xsteps, *ysteps;
+	Uint32 *rows[2], *vrow, *sums, *out;
+	const Uint32 *row0, *row1;
+	Uint8 *dstp;
+	SDL_Rect full_src;
+	SDL_Rect full_dst;
+	const int src_bpp = src->format->BytesPerPixel;
+	const int dst_bpp = dst->format->BytesPerPixel;
+
+	if ( filter == SDL_STRETCH_NEAREST &&
+	     SDL_StretchSameFormat(src->format, dst->format) ) {
+		return SDL_SoftStretch(src, srcrect, dst, dstrect);
+	}
+	if ( (src_bpp < 2) || (dst_bpp < 2) ) {
+		if ( filter == SDL_STRETCH_NEAREST ) {
+			SDL_SetError("Stretching 8 bpp surfaces needs the same palette");
+		} else {
+			SDL_SetError("Filtered stretch needs 16, 24 or 32 bpp surfaces");
+		}
+		return(-1);
+	}
+
+	/* Verify the blit rectangles */
+	if ( srcrect ) {
+		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
+		     ((srcrect->x+srcrect->w) > src->w) ||
+		     ((srcrect->y+srcrect->h) > src->h) ) {
+			SDL_SetError("Invalid source blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_src.x = 0;
+		full_src.y = 0;
+		full_src.w = src->w;
+		full_src.h = src->h;
+		srcrect = &full_src;
+	}
+	if ( dstrect ) {
+		if ( (dstrect->x < 0) || (dstrect->y < 0) ||
+		     ((dstrect->x+dstrect->w) > dst->w) ||
+		     ((dstrect->y+dstrect->h) > dst->h) ) {
+			SDL_SetError("Invalid destination blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_dst.x = 0;
+		full_dst.y = 0;
+		full_dst.w = dst->w;
+		full_dst.h = dst->h;
+		dstrect = &full_dst;
+	}
+	src_w = srcrect->w;
+	src_h = srcrect->h;
+	dst_w = dstrect->w;
+	dst_h = dstrect->h;
+	if ( !src_w || !src_h || !dst_w || !dst_h ) {
+		return(0);
+	}
+
+	/* Set up the sampling positions and the row buffers */
+	direct = SDL_StretchDirect8888(src->format, dst->format);
+	hmode = SDL_StretchStepMode(filter, src_w, dst_w);
+	vmode = SDL_StretchStepMode(filter, src_h, dst_h);
+	buffer = (Uint8 *)SDL_malloc(
+		(dst_w + dst_h) * sizeof(SDL_StretchStep) +
+		(4 * src_w + 4 * src_w + dst_w) * sizeof(Uint32));
+	if ( buffer == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	xsteps = (SDL_StretchStep *)buffer;
+	ysteps = xsteps + dst_w;
+	rows[0] = (Uint32 *)(ysteps + dst_h);
+	rows[1] = rows[0] + src_w;
+	vrow = rows[1] + src_w;
+	sums = vrow + src_w;
+	out = sums + 4 * src_w;
+	cached[0] = cached[1] = -1;
+	SDL_StretchSteps(hmode, src_w, dst_w, xsteps);
+	SDL_StretchSteps(vmode, src_h, dst_h, ysteps);
+
+	/* Record the damage, so locking the screen doesn't count as such */
+	SDL_DamageRect(dst, dstrect);
+	SDL_HoldDamage(dst);
+
+	/* Lock the destination if it's in hardware */
+	dst_locked = 0;
+	if ( SDL_MUSTLOCK(dst) ) {
+		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_free(buffer);
+			SDL_ReleaseDamage(dst);
+			SDL_SetError("Unable to lock destination surface");
+			return(-1);
+		}
+		dst_locked = 1;
+	}
+	/* Lock the source if it's in hardware */
+	src_locked = 0;
+	if ( SDL_MUSTLOCK(src) ) {
+		if ( SDL_LockSurface(src) < 0 ) {
+			if ( dst_locked ) {
+				SDL_UnlockSurface(dst);
+			}
+			SDL_free(buffer);
+			SDL_ReleaseDamage(dst);
+			SDL_SetError("Unable to lock source surface");
+			return(-1);
+		}
+		src_locked = 1;
+	}
+
+	for ( y = 0; y < dst_h; ++y ) {
+		const SDL_StretchStep *ys = &ysteps[y];
+
+		/* Vertical pass */
+		switch (vmode) {
+		    case STRETCH_STEP_AREA:
+			SDL_memset(sums, 0, 4 * src_w * sizeof(Uint32));
+			for ( i = ys->i0; i < ys->i1; ++i ) {
+				row0 = SDL_StretchFetchRow(src, srcrect, direct,
+				                           rows, cached, i, -1);
+				SDL_StretchAccumulateRow(row0, sums, src_w);
+			}
+			if ( hmode == STRETCH_STEP_AREA ) {
+				/* Averaged in one go by the horizontal pass */
+				break;
+			}
+			for ( x = 0; x < src_w; ++x ) {
+				vrow[x] = SDL_StretchAverage(&sums[x * 4],
+				                             ys->i1 - ys->i0);
+			}
+			row0 = vrow;
+			break;
+		    case STRETCH_STEP_LINEAR:
+			row0 = SDL_StretchFetchRow(src, srcrect, direct,
+			                           rows, cached, ys->i0, -1);
+			if ( ys->w ) {
+				row1 = SDL_StretchFetchRow(src, srcrect, direct,
+				                           rows, cached, ys->i1,
+				                           (row0 == rows[0]) ? 0 : 1);
+				SDL_StretchLerpRow(row0, row1, vrow, src_w, ys->w);
+				row0 = vrow;
+			}
+			break;
+		    default:
+			row0 = SDL_StretchFetchRow(src, srcrect, direct,
+			                           rows, cached, ys->i0, -1);
+			break;
+		}
+
+		/* Horizontal pass */
+		dstp = (Uint8 *)dst->pixels + ((dstrect->y + y) * dst->pitch)
+		                            + (dstrect->x * dst_bpp);
+		{
+			Uint32 *outp = direct ? (Uint32 *)dstp : out;
+
+			switch (hmode) {
+			    case STRETCH_STEP_AREA:
+				for ( x = 0; x < dst_w; ++x ) {
+					const SDL_StretchStep *xs = &xsteps[x];
+					Uint32 s[4] = { 0, 0, 0, 0 };
+					Uint32 count = xs->i1 - xs->i0;
+					if ( vmode == STRETCH_STEP_AREA ) {
+						for ( i = xs->i0; i < xs->i1; ++i ) {
+							s[0] += sums[i * 4 + 0];
+							s[1] += sums[i * 4 + 1];
+							s[2] += sums[i * 4 + 2];
+							s[3] += sums[i * 4 + 3];
+						}
+						count *= ys->i1 - ys->i0;
+					} else {
+						for ( i = xs->i0; i < xs->i1; ++i ) {
+							const Uint32 p = row0[i];
+							s[0] += (p & 0xFF);
+							s[1] += ((p >> 8) & 0xFF);
+							s[2] += ((p >> 16) & 0xFF);
+							s[3] += (p >> 24);
+						}
+					}
+					outp[x] = SDL_StretchAverage(s, count);
+				}
+				break;
+			    case STRETCH_STEP_LINEAR:
+				for ( x = 0; x < dst_w; ++x ) {
+					const SDL_StretchStep *xs = &xsteps[x];
+					outp[x] = SDL_StretchLerp(row0[xs->i0],
+					                          row0[xs->i1], xs->w);
+				}
+				break;
+			    default:
+				for ( x = 0; x < dst_w; ++x ) {
+					outp[x] = row0[xsteps[x].i0];
+				}
+				break;
+			}
+			if ( !direct ) {
+				SDL_StretchPackRow(out, dstp, dst->format, dst_w);
+			}
+		}
+	}
+
+	/* We need to unlock the surfaces if they're locked */
+	if ( dst_locked ) {
+		SDL_UnlockSurface(dst);
+	}
+	if ( src_locked ) {
+		SDL_UnlockSurface(src);
+	}
+	SDL_ReleaseDamage(dst);
+	SDL_free(buffer);
+	return(0);
+}
@@ -27,8 +27,11 @@
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_region_c.h"
+#include "SDL_present_c.h"
 #include "SDL_leaks.h"
 #include "SDL_cpuinfo.h"
+#include "../thread/SDL_thread_c.h"
 
 
 /* Public routines */
@@ -411,6 +414,7 @@ int SDL_LowerBlit (SDL_Surface *src, SDL_Rect *srcrect,
 	SDL_blit do_blit;
 	SDL_Rect hw_srcrect;
 	SDL_Rect hw_dstrect;
+	int retval;
 
 	/* Check to make sure the blit mapping is valid */
 	if ( (src->map->dst != dst) ||
@@ -438,7 +442,15 @@ int SDL_LowerBlit (SDL_Surface *src, SDL_Rect *srcrect,
 	} else {
 		do_blit = src->map->sw_blit;
 	}
-	return(do_blit(src, srcrect, dst, dstrect));
+
+	/* Only the destination rectangle is damaged by the blit itself */
+	SDL_DamageRect(dst, dstrect);
+	SDL_HoldDamage(src);
+	SDL_HoldDamage(dst);
+	retval = do_blit(src, srcrect, dst, dstrect);
+	SDL_ReleaseDamage(dst);
+	SDL_ReleaseDamage(src);
+	return(retval);
 }
 
 
@@ -548,59 +560,92 @@ static int SDL_FillRect4(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 	return -1;
 }
 
-/* 
- * This function performs a fast fill of the given rectangle with 'color'
- */
-int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+#if SDL_ASSEMBLY_ROUTINES
+#if defined(__SSE2__) || (defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))))
+#define SSE2_FILLRECT
+#include <emmintrin.h>
+#endif
+#endif /* SDL_ASSEMBLY_ROUTINES */
+
+#ifdef SSE2_FILLRECT
+/* Fill rows with a repeating pixel pattern using aligned SSE2 stores.
+   48 bytes hold a whole number of pixels for every depth, so each row is
+   filled in 48 byte steps with three vectors taken from the pattern at
+   the phase left over by the unaligned start of the row. */
+static void SDL_FillRectSSE2(Uint8 *row, int pitch, int w, int h,
+                             int bpp, Uint32 color)
 {
-	SDL_VideoDevice *video = current_video;
-	SDL_VideoDevice *this  = current_video;
-	int x, y;
-	Uint8 *row;
+	Uint8 pattern[64];
+	const int len = w * bpp;
+	const int stream = (len * h > SDL_GetStreamThreshold());
+	int i, y;
 
-	/* This function doesn't work on surfaces < 8 bpp */
-	if ( dst->format->BitsPerPixel < 8 ) {
-		switch(dst->format->BitsPerPixel) {
+	for ( i = 0; i + 4 <= (int)sizeof(pattern); i += bpp ) {
+		switch (bpp) {
 		    case 1:
-			return SDL_FillRect1(dst, dstrect, color);
+			pattern[i] = (Uint8)color;
 			break;
-		    case 4:
-			return SDL_FillRect4(dst, dstrect, color);
+		    case 2:
+			*(Uint16 *)&pattern[i] = (Uint16)color;
+			break;
+		    case 3:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+			pattern[i+0] = (Uint8)(color);
+			pattern[i+1] = (Uint8)(color >> 8);
+			pattern[i+2] = (Uint8)(color >> 16);
+#else
+			pattern[i+0] = (Uint8)(color >> 16);
+			pattern[i+1] = (Uint8)(color >> 8);
+			pattern[i+2] = (Uint8)(color);
+#endif
 			break;
 		    default:
-			SDL_SetError("Fill rect on unsupported surface format");
-			return(-1);
+			*(Uint32 *)&pattern[i] = color;
 			break;
 		}
 	}
 
-	/* If 'dstrect' == NULL, then fill the whole surface */
-	if ( dstrect ) {
-		/* Perform clipping */
-		if ( !SDL_IntersectRect(dstrect, &dst->clip_rect, dstrect) ) {
-			return(0);
+	for ( y = h; y; --y, row += pitch ) {
+		Uint8 *d = row;
+		int head = (int)((16 - ((uintptr_t)d & 15)) & 15);
+		int n = len - head;
+		int phase = head % bpp;
+		__m128i v0, v1, v2;
+
+		SDL_memcpy(d, pattern, head);
+		d += head;
+		v0 = _mm_loadu_si128((const __m128i *)(pattern + phase));
+		v1 = _mm_loadu_si128((const __m128i *)(pattern + phase + 16));
+		v2 = _mm_loadu_si128((const __m128i *)(pattern + phase + 32));
+		if ( stream ) {
+			for ( ; n >= 48; n -= 48, d += 48 ) {
+				_mm_stream_si128((__m128i *)(d +  0), v0);
+				_mm_stream_si128((__m128i *)(d + 16), v1);
+				_mm_stream_si128((__m128i *)(d + 32), v2);
+			}
+		} else {
+			for ( ; n >= 48; n -= 48, d += 48 ) {
+				_mm_store_si128((__m128i *)(d +  0), v0);
+				_mm_store_si128((__m128i *)(d + 16), v1);
+				_mm_store_si128((__m128i *)(d + 32), v2);
+			}
 		}
-	} else {
-		dstrect = &dst->clip_rect;
+		SDL_memcpy(d, pattern + phase, n);
 	}
-
-	/* Check for hardware acceleration */
-	if ( ((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
-					video->info.blit_fill ) {
-		SDL_Rect hw_rect;
-		if ( dst == SDL_VideoSurface ) {
-			hw_rect = *dstrect;
-			hw_rect.x += current_video->offset_x;
-			hw_rect.y += current_video->offset_y;
-			dstrect = &hw_rect;
-		}
-		return(video->FillHWRect(this, dst, dstrect, color));
+	if ( stream ) {
+		_mm_sfence();
 	}
+}
+#endif /* SSE2_FILLRECT */
+
+/*
+ * Fill an already clipped rectangle of a locked surface in software
+ */
+void SDL_FillRectSoftware(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	int x, y;
+	Uint8 *row;
 
-	/* Perform software fill */
-	if ( SDL_LockSurface(dst) != 0 ) {
-		return(-1);
-	}
 	row = (Uint8 *)dst->pixels+dstrect->y*dst->pitch+
 			dstrect->x*dst->format->BytesPerPixel;
 #if SDL_ARM_NEON_BLITTERS
@@ -620,8 +665,7 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
             break;
         }
 
-        SDL_UnlockSurface(dst);
-        return(0);
+        return;
     }
 #endif
 #if SDL_ARM_SIMD_BLITTERS
@@ -641,8 +685,15 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			break;
 		}
 
-		SDL_UnlockSurface(dst);
-		return(0);
+		return;
+	}
+#endif
+#ifdef SSE2_FILLRECT
+	if ( (dstrect->w*dst->format->BytesPerPixel >= 64) && SDL_HasSSE2() ) {
+		SDL_FillRectSSE2(row, dst->pitch,
+		                 dstrect->w, dstrect->h,
+		                 dst->format->BytesPerPixel, color);
+		return;
 	}
 #endif
 	if ( dst->format->palette || (color == 0) ) {
@@ -767,18 +818,124 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
 			break;
 		}
 	}
+}
+
+/* 
+ * This function performs a fast fill of the given rectangle with 'color'
+ */
+int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+
+	/* This function doesn't work on surfaces < 8 bpp */
+	if ( dst->format->BitsPerPixel < 8 ) {
+		switch(dst->format->BitsPerPixel) {
+		    case 1:
+			return SDL_FillRect1(dst, dstrect, color);
+			break;
+		    case 4:
+			return SDL_FillRect4(dst, dstrect, color);
+			break;
+		    default:
+			SDL_SetError("Fill rect on unsupported surface format");
+			return(-1);
+			break;
+		}
+	}
+
+	/* If 'dstrect' == NULL, then fill the whole surface */
+	if ( dstrect ) {
+		/* Perform clipping */
+		if ( !SDL_IntersectRect(dstrect, &dst->clip_rect, dstrect) ) {
+			return(0);
+		}
+	} else {
+		dstrect = &dst->clip_rect;
+	}
+	SDL_DamageRect(dst, dstrect);
+
+	/* Check for hardware acceleration */
+	if ( ((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
+					video->info.blit_fill ) {
+		SDL_Rect hw_rect;
+		if ( dst == SDL_VideoSurface ) {
+			hw_rect = *dstrect;
+			hw_rect.x += current_video->offset_x;
+			hw_rect.y += current_video->offset_y;
+			dstrect = &hw_rect;
+		}
+		return(video->FillHWRect(this, dst, dstrect, color));
+	}
+
+	/* Perform software fill */
+	SDL_HoldDamage(dst);
+	if ( SDL_LockSurface(dst) != 0 ) {
+		SDL_ReleaseDamage(dst);
+		return(-1);
+	}
+	SDL_FillRectSoftware(dst, dstrect, color);
 	SDL_UnlockSurface(dst);
+	SDL_ReleaseDamage(dst);
 
 	/* We're done! */
 	return(0);
 }
 
+/*
+ * Fill a list of rectangles, clipping and locking the surface only once
+ */
+int SDL_FillRects(SDL_Surface *dst, const SDL_Rect *rects, int num, Uint32 color)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_Rect rect;
+	int i, retval;
+
+	if ( !rects ) {
+		return SDL_FillRect(dst, NULL, color);
+	}
+
+	/* Odd depths and hardware fills go through the single rect path */
+	if ( (dst->format->BitsPerPixel < 8) ||
+	     (((dst->flags & SDL_HWSURFACE) == SDL_HWSURFACE) &&
+	      video->info.blit_fill) ) {
+		retval = 0;
+		for ( i = 0; i < num; ++i ) {
+			rect = rects[i];
+			if ( SDL_FillRect(dst, &rect, color) < 0 ) {
+				retval = -1;
+			}
+		}
+		return(retval);
+	}
+
+	/* Perform software fill */
+	SDL_HoldDamage(dst);
+	if ( SDL_LockSurface(dst) != 0 ) {
+		SDL_ReleaseDamage(dst);
+		return(-1);
+	}
+	for ( i = 0; i < num; ++i ) {
+		if ( SDL_IntersectRect(&rects[i], &dst->clip_rect, &rect) ) {
+			SDL_DamageRect(dst, &rect);
+			SDL_FillRectSoftware(dst, &rect, color);
+		}
+	}
+	SDL_UnlockSurface(dst);
+	SDL_ReleaseDamage(dst);
+	return(0);
+}
+
 /*
  * Lock a surface to directly access the pixels
  */
 int SDL_LockSurface (SDL_Surface *surface)
 {
 	if ( ! surface->locked ) {
+		/* The present thread may be drawing on the video surface */
+		if ( current_video && surface == SDL_VideoSurface ) {
+			SDL_WaitPresent(current_video);
+		}
 		/* Perform the lock */
 		if ( surface->flags & (SDL_HWSURFACE|SDL_ASYNCBLIT) ) {
 			SDL_VideoDevice *video = current_video;
@@ -791,6 +948,9 @@ int SDL_LockSurface (SDL_Surface *surface)
 			SDL_UnRLESurface(surface, 1);
 			surface->flags |= SDL_RLEACCEL;	/* save accel'd state */
 		}
+		/* The pixels may be changed, so don't reuse the encoding */
+		SDL_FreeRLECache(surface->map);
+		SDL_DamageLocked(surface);
 		/* This needs to be done here in case pixels changes value */
 		surface->pixels = (Uint8 *)surface->pixels + surface->offset;
 	}
@@ -828,6 +988,89 @@ void SDL_UnlockSurface (SDL_Surface *surface)
 	}
 }
 
+/* Conversions are split into bands of rows, converted in parallel */
+#define CONVERT_BAND_PIXELS	(256 * 256)	/* smallest band worth a thread */
+
+typedef struct {
+	SDL_Surface *src;
+	SDL_Surface *dst;
+	SDL_BlitMap *map;
+	int numbands;
+} SDL_ConvertJob;
+
+static void SDL_ConvertBand(void *data, int index)
+{
+	SDL_ConvertJob *job = (SDL_ConvertJob *)data;
+	SDL_Surface *src = job->src;
+	SDL_Surface *dst = job->dst;
+	SDL_BlitInfo info;
+	int y, h;
+
+	y = src->h * index / job->numbands;
+	h = src->h * (index + 1) / job->numbands - y;
+	if ( h <= 0 ) {
+		return;
+	}
+	info.s_pixels = (Uint8 *)src->pixels + y*src->pitch;
+	info.s_width = src->w;
+	info.s_height = h;
+	info.s_skip = src->pitch - src->w*src->format->BytesPerPixel;
+	info.d_pixels = (Uint8 *)dst->pixels + y*dst->pitch;
+	info.d_width = src->w;
+	info.d_height = h;
+	info.d_skip = dst->pitch - src->w*dst->format->BytesPerPixel;
+	info.aux_data = job->map->sw_data->aux_data;
+	info.src = src->format;
+	info.table = job->map->table;
+	info.dst = dst->format;
+	job->map->sw_data->blit(&info);
+}
+
+/*
+ * Copy the pixels of a software surface into a new surface of another
+ * format.  The blit is set up in a private map, with the source surface
+ * flags replaced by 'blit_flags', so the source isn't changed at all and
+ * can be converted by several threads at once.
+ */
+static int SDL_ConvertPixels(SDL_Surface *surface, SDL_Surface *convert,
+                             Uint32 blit_flags)
+{
+	SDL_Surface src;
+	SDL_ConvertJob job;
+	int numbands;
+
+	src = *surface;
+	src.flags &= ~(SDL_SRCCOLORKEY|SDL_SRCALPHA|SDL_RLEACCELOK|SDL_HWACCEL);
+	src.flags |= blit_flags;
+	src.map = SDL_AllocBlitMap();
+	if ( src.map == NULL ) {
+		return(-1);
+	}
+	if ( SDL_MapSurface(&src, convert) < 0 ) {
+		SDL_FreeBlitMap(src.map);
+		return(-1);
+	}
+
+	numbands = (src.w * src.h) / CONVERT_BAND_PIXELS;
+	if ( numbands > SDL_GetCPUCount() ) {
+		numbands = SDL_GetCPUCount();
+	}
+	if ( numbands > src.h ) {
+		numbands = src.h;
+	}
+	if ( numbands < 1 ) {
+		numbands = 1;
+	}
+	job.src = &src;
+	job.dst = convert;
+	job.map = src.map;
+	job.numbands = numbands;
+	SDL_ParallelFor(numbands, SDL_ConvertBand, &job);
+
+	SDL_FreeBlitMap(src.map);
+	return(0);
+}
+
 /* 
  * Convert a surface into the specified pixel format.
  */
@@ -839,6 +1082,7 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 	Uint8 alpha = 0;
 	Uint32 surface_flags;
 	SDL_Rect bounds;
+	int direct;
 
 	/* Check for empty destination palette! (results in empty image) */
 	if ( format->palette != NULL ) {
@@ -879,6 +1123,10 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 		convert->format->palette->ncolors = format->palette->ncolors;
 	}
 
+	/* Software surfaces are converted without changing the source, and
+	   anything else is blitted with the color key and alpha turned off */
+	direct = (!SDL_MUSTLOCK(surface) && !SDL_MUSTLOCK(convert));
+
 	/* Save the original surface color key and alpha */
 	surface_flags = surface->flags;
 	if ( (surface_flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY ) {
@@ -888,25 +1136,40 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 			surface_flags &= ~SDL_SRCCOLORKEY;
 		} else {
 			colorkey = surface->format->colorkey;
-			SDL_SetColorKey(surface, 0, 0);
+			if ( !direct ) {
+				SDL_SetColorKey(surface, 0, 0);
+			}
 		}
 	}
 	if ( (surface_flags & SDL_SRCALPHA) == SDL_SRCALPHA ) {
 		/* Copy over the alpha channel to RGBA if requested */
 		if ( format->Amask ) {
-			surface->flags &= ~SDL_SRCALPHA;
+			if ( !direct ) {
+				surface->flags &= ~SDL_SRCALPHA;
+			}
 		} else {
 			alpha = surface->format->alpha;
-			SDL_SetAlpha(surface, 0, 0);
+			if ( !direct ) {
+				SDL_SetAlpha(surface, 0, 0);
+			}
 		}
 	}
 
 	/* Copy over the image data */
-	bounds.x = 0;
-	bounds.y = 0;
-	bounds.w = surface->w;
-	bounds.h = surface->h;
-	SDL_LowerBlit(surface, &bounds, convert, &bounds);
+	if ( direct ) {
+		/* The color key is only used when converting it to alpha */
+		if ( SDL_ConvertPixels(surface, convert, (surface->flags &
+		                       ~surface_flags) & SDL_SRCCOLORKEY) < 0 ) {
+			SDL_FreeSurface(convert);
+			return(NULL);
+		}
+	} else {
+		bounds.x = 0;
+		bounds.y = 0;
+		bounds.w = surface->w;
+		bounds.h = surface->h;
+		SDL_LowerBlit(surface, &bounds, convert, &bounds);
+	}
 
 	/* Clean up the original surface, and update converted surface */
 	if ( convert != NULL ) {
@@ -921,7 +1184,9 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 			SDL_SetColorKey(convert, cflags|(flags&SDL_RLEACCELOK),
 				SDL_MapRGB(convert->format, keyR, keyG, keyB));
 		}
-		SDL_SetColorKey(surface, cflags, colorkey);
+		if ( !direct ) {
+			SDL_SetColorKey(surface, cflags, colorkey);
+		}
 	}
 	if ( (surface_flags & SDL_SRCALPHA) == SDL_SRCALPHA ) {
 		Uint32 aflags = surface_flags&(SDL_SRCALPHA|SDL_RLEACCELOK);
@@ -929,10 +1194,12 @@ SDL_Surface * SDL_ConvertSurface (SDL_Surface *surface,
 		        SDL_SetAlpha(convert, aflags|(flags&SDL_RLEACCELOK),
 				alpha);
 		}
-		if ( format->Amask ) {
-			surface->flags |= SDL_SRCALPHA;
-		} else {
-			SDL_SetAlpha(surface, aflags, alpha);
+		if ( !direct ) {
+			if ( format->Amask ) {
+				surface->flags |= SDL_SRCALPHA;
+			} else {
+				SDL_SetAlpha(surface, aflags, alpha);
+			}
 		}
 	}
 
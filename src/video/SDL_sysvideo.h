@@ -25,6 +25,7 @@
 #define _SDL_sysvideo_h
 
 #include "SDL_mouse.h"
+#include "SDL_thread.h"
 #define SDL_PROTOTYPES_ONLY
 #include "SDL_syswm.h"
 #undef SDL_PROTOTYPES_ONLY
@@ -258,6 +259,17 @@ struct SDL_VideoDevice {
 	/* Handle any queued OS events */
 	void (*PumpEvents)(_THIS);
 
+	/* Wait up to 'timeout' milliseconds, or forever if it is negative,
+	   for OS events to arrive or for WakeEvents() to be called.
+	   This returns 0, or -1 if the driver can't wait, in which case
+	   SDL polls PumpEvents() instead.
+	 */
+	int (*WaitEvents)(_THIS, int timeout);
+
+	/* Make WaitEvents() return -- may be called from any thread, and
+	   from a signal handler, so it may only use async-signal-safe calls */
+	void (*WakeEvents)(_THIS);
+
 	/* * * */
 	/* Data common to all drivers */
 	SDL_Surface *screen;
@@ -270,9 +282,29 @@ struct SDL_VideoDevice {
 	int offset_x;
 	int offset_y;
 	SDL_GrabMode input_grab;
+	SDL_Rect *update_rects;	/* scratch space for merging updates */
+	int max_update_rects;
+	SDL_UpdateStats update_stats;
+	Uint8 *damage;		/* damaged tiles, if tracking damage */
+	int damage_cols;
+	int damage_rows;
+	int damage_hold;	/* locks that aren't damage by themselves */
+	SDL_Rect *damage_rects;
+	SDL_Surface *present;	/* frame being presented by the thread */
+	SDL_Thread *present_thread;
+	SDL_mutex *present_lock;
+	SDL_cond *present_cond;
+	int present_state;
+	int present_numrects;
+	SDL_Rect *present_rects;
+	int max_present_rects;
+	SDL_FrameCallback frame_callback;	/* see SDL_SetFrameCallback() */
+	void *frame_callback_data;
 
 	/* Driver information flags */
 	int handles_any_size;	/* Driver handles any size video mode */
+	int threaded_update;	/* UpdateRects() may be called from any thread */
+	int handles_frame_callback;	/* Driver calls the frame callback */
 
 	/* * * */
 	/* Data used by the GL drivers */
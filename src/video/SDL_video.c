@@ -27,6 +27,8 @@
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_pixels_c.h"
+#include "SDL_region_c.h"
+#include "SDL_present_c.h"
 #include "SDL_cursor_c.h"
 #include "../events/SDL_sysevents.h"
 #include "../events/SDL_events_c.h"
@@ -625,6 +627,11 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 		return(NULL);
 	}
 
+	/* Start counting updates afresh for the new mode */
+	SDL_memset(&video->update_stats, 0, sizeof(video->update_stats));
+	SDL_FreeDamage(video);
+	SDL_StopPresent(video);
+
 	/* Check the requested flags */
 	/* There's no palette in > 8 bits-per-pixel mode */
 	if ( video_bpp > 8 ) {
@@ -910,6 +917,7 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 			return(NULL);
 		}
 		SDL_PublicSurface = SDL_ShadowSurface;
+		SDL_StartPresent(video);
 	} else {
 		SDL_PublicSurface = SDL_VideoSurface;
 	}
@@ -1034,16 +1042,79 @@ void SDL_UpdateRect(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h)
 		SDL_UpdateRects(screen, 1, &rect);
 	}
 }
+/*
+ * Merge the rectangles of an update, so each pixel is copied only once
+ * and the driver doesn't have to push hundreds of tiny rectangles.
+ * Returns the rectangles to update, which may be the ones passed in.
+ */
+static SDL_Rect *SDL_MergeUpdateRects(SDL_Surface *screen,
+                                      int *numrects, SDL_Rect *rects)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_Rect bounds;
+	int max;
+
+	bounds.x = 0;
+	bounds.y = 0;
+	bounds.w = screen->w;
+	bounds.h = screen->h;
+
+	/* Leave some room to split overlapping rectangles */
+	max = *numrects * 2 + 8;
+	if ( max > video->max_update_rects ) {
+		SDL_Rect *update_rects;
+		update_rects = (SDL_Rect *)SDL_realloc(video->update_rects,
+		                                      max*sizeof(*update_rects));
+		if ( update_rects == NULL ) {
+			return(rects);
+		}
+		video->update_rects = update_rects;
+		video->max_update_rects = max;
+	}
+	*numrects = SDL_CoalesceRects(rects, *numrects, &bounds,
+	                   video->update_rects, video->max_update_rects);
+	return(video->update_rects);
+}
+
 void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 {
 	int i;
 	SDL_VideoDevice *video = current_video;
 	SDL_VideoDevice *this = current_video;
+	SDL_UpdateStats *stats = &video->update_stats;
+	Uint32 pixels_in, pixels_out;
 
 	if ( (screen->flags & (SDL_OPENGL | SDL_OPENGLBLIT)) == SDL_OPENGL ) {
 		SDL_SetError("OpenGL active, use SDL_GL_SwapBuffers()");
 		return;
 	}
+
+	/* Merge the rectangles, keeping track of what that saves */
+	pixels_in = 0;
+	for ( i=0; i<numrects; ++i ) {
+		pixels_in += (Uint32)rects[i].w * rects[i].h;
+	}
+	stats->updates++;
+	stats->rects_in += numrects;
+	stats->pixels_in += pixels_in;
+	if ( numrects > 1 ) {
+		rects = SDL_MergeUpdateRects(screen, &numrects, rects);
+	}
+	pixels_out = 0;
+	for ( i=0; i<numrects; ++i ) {
+		pixels_out += (Uint32)rects[i].w * rects[i].h;
+	}
+	stats->rects_out += numrects;
+	stats->pixels_out += pixels_out;
+	if ( pixels_in > pixels_out ) {
+		stats->bytes_saved += (pixels_in - pixels_out) *
+		                      screen->format->BytesPerPixel;
+	}
+	if ( screen == SDL_ShadowSurface && video->present_thread ) {
+		/* The present thread takes it from here */
+		SDL_QueuePresent(video, numrects, rects);
+		return;
+	}
 	if ( screen == SDL_ShadowSurface ) {
 		/* Blit the shadow surface using saved mapping */
 		SDL_Palette *pal = screen->format->palette;
@@ -1099,12 +1170,100 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 	}
 }
 
+int SDL_SetDamageTracking(SDL_Surface *screen, int enable)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( !video || !screen || screen != SDL_PublicSurface ) {
+		SDL_SetError("Damage can only be tracked on the display surface");
+		return(-1);
+	}
+	if ( (screen->flags & SDL_OPENGL) == SDL_OPENGL ) {
+		SDL_SetError("OpenGL active, use SDL_GL_SwapBuffers()");
+		return(-1);
+	}
+	if ( !enable ) {
+		SDL_FreeDamage(video);
+		return(0);
+	}
+	if ( video->damage ) {
+		return(0);
+	}
+	return(SDL_AllocDamage(video, screen->w, screen->h));
+}
+
+void SDL_UpdateDamage(SDL_Surface *screen)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_Rect *rects;
+	int numrects;
+
+	if ( !video->damage || screen != SDL_PublicSurface ) {
+		SDL_UpdateRect(screen, 0, 0, 0, 0);
+		return;
+	}
+	numrects = SDL_CollectDamage(video, &rects);
+	if ( numrects > 0 ) {
+		SDL_UpdateRects(screen, numrects, rects);
+	}
+}
+
+int SDL_SetFrameCallback(SDL_FrameCallback callback, void *userdata)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( !video ) {
+		SDL_SetError("Video subsystem has not been initialized");
+		return(-1);
+	}
+	if ( !video->handles_frame_callback ) {
+		SDL_SetError("Frame callbacks aren't supported by this video driver");
+		return(-1);
+	}
+	SDL_WaitPresent(video);
+	video->frame_callback = callback;
+	video->frame_callback_data = userdata;
+	return(0);
+}
+
+void SDL_GetUpdateStats(SDL_UpdateStats *stats)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( video ) {
+		*stats = video->update_stats;
+	} else {
+		SDL_memset(stats, 0, sizeof(*stats));
+	}
+}
+
+void SDL_ResetUpdateStats(void)
+{
+	SDL_VideoDevice *video = current_video;
+
+	if ( video ) {
+		SDL_memset(&video->update_stats, 0, sizeof(video->update_stats));
+	}
+}
+
 /*
  * Performs hardware double buffering, if possible, or a full update if not.
  */
 int SDL_Flip(SDL_Surface *screen)
 {
 	SDL_VideoDevice *video = current_video;
+	/* Only the damaged parts need updating, if that's being tracked and
+	   there's no second buffer to bring up to date */
+	if ( video->damage && screen == SDL_PublicSurface &&
+	     (SDL_VideoSurface->flags & SDL_DOUBLEBUF) != SDL_DOUBLEBUF ) {
+		SDL_UpdateDamage(screen);
+		return(0);
+	}
+	/* Let the present thread copy the shadow surface */
+	if ( screen == SDL_ShadowSurface && video->present_thread ) {
+		SDL_UpdateRect(screen, 0, 0, 0, 0);
+		return(0);
+	}
 	/* Copy the shadow surface to the video surface */
 	if ( screen == SDL_ShadowSurface ) {
 		SDL_Rect rect;
@@ -1286,6 +1445,10 @@ int SDL_SetPalette(SDL_Surface *screen, int which,
 	}
 	gotall = 1;
 	palsize = 1 << screen->format->BitsPerPixel;
+	if ( which & SDL_PHYSPAL ) {
+		/* The video surface colors may be in use by the present thread */
+		SDL_WaitPresent(current_video);
+	}
 	if ( ncolors > (palsize - firstcolor) ) {
 		ncolors = (palsize - firstcolor);
 		gotall = 0;
@@ -1351,6 +1514,7 @@ void SDL_VideoQuit (void)
 
 		/* Halt event processing before doing anything else */
 		SDL_StopEventLoop();
+		SDL_StopPresent(video);
 
 		/* Clean up allocated window manager items */
 		if ( SDL_PublicSurface ) {
@@ -1393,6 +1557,12 @@ void SDL_VideoQuit (void)
 			SDL_free(video->wm_title);
 			video->wm_title = NULL;
 		}
+		if ( video->update_rects != NULL ) {
+			SDL_free(video->update_rects);
+			video->update_rects = NULL;
+			video->max_update_rects = 0;
+		}
+		SDL_FreeDamage(video);
 		if ( video->wm_icon != NULL ) {
 			SDL_free(video->wm_icon);
 			video->wm_icon = NULL;
@@ -1941,6 +2111,7 @@ int SDL_WM_ToggleFullScreen(SDL_Surface *surface)
 	toggled = 0;
 	if ( SDL_PublicSurface && (surface == SDL_PublicSurface) &&
 	     video->ToggleFullScreen ) {
+		SDL_WaitPresent(video);
 		if ( surface->flags & SDL_FULLSCREEN ) {
 			toggled = video->ToggleFullScreen(this, 0);
 			if ( toggled ) {
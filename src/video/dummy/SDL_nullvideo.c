@@ -31,6 +31,22 @@
  *  is a performance problem for a given platform, enable this driver, and
  *  then see if your application runs faster without video overhead.
  *
+ * For testing without a display, a few environment variables make it
+ *  a bit less of a dummy:
+ *   SDL_VIDEO_DUMMY_CAPTURE=dir	save every update to dir/frameNNNNNN.bmp
+ *   SDL_VIDEO_DUMMY_CAPTURE_FORMAT=raw	save bare pixels instead of BMPs
+ *   SDL_VIDEO_DUMMY_REFRESH=hz		wait for a virtual retrace on updates
+ *   SDL_VIDEO_DUMMY_STATS=1		print frame counts on exit
+ *  and to look more like a real display:
+ *   SDL_VIDEO_DUMMY_FORMAT=bpp		fixed display depth (8, 15, 16, 24, 32)
+ *   SDL_VIDEO_DUMMY_MODES=WxH,WxH	fixed list of video modes
+ *   SDL_VIDEO_DUMMY_VIDMEM=kb		emulated video memory for hardware
+ *					surfaces, with "accelerated" blits
+ *   SDL_VIDEO_DUMMY_ACCEL=blit,colorkey,alpha,fill
+ *					the accelerations to report, all
+ *					of them by default
+ *  Programs can also look at the frames with SDL_SetFrameCallback().
+ *
  * Initial work by Ryan C. Gordon (icculus@icculus.org). A good portion
  *  of this was cut-and-pasted from Stephane Peter's work in the AAlib
  *  SDL video driver.  Renamed to "DUMMY" by Sam Lantinga.
@@ -38,8 +54,11 @@
 
 #include "SDL_video.h"
 #include "SDL_mouse.h"
+#include "SDL_timer.h"
 #include "../SDL_sysvideo.h"
+#include "../SDL_blit.h"
 #include "../SDL_pixels_c.h"
+#include "../SDL_region_c.h"
 #include "../../events/SDL_events_c.h"
 
 #include "SDL_nullvideo.h"
@@ -48,6 +67,9 @@
 
 #define DUMMYVID_DRIVER_NAME "dummy"
 
+#define surfaces		(this->hidden->surfaces)
+#define surfaces_memleft	(this->hidden->surfaces_memleft)
+
 /* Initialization/Query functions */
 static int DUMMY_VideoInit(_THIS, SDL_PixelFormat *vformat);
 static SDL_Rect **DUMMY_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flags);
@@ -60,6 +82,12 @@ static int DUMMY_AllocHWSurface(_THIS, SDL_Surface *surface);
 static int DUMMY_LockHWSurface(_THIS, SDL_Surface *surface);
 static void DUMMY_UnlockHWSurface(_THIS, SDL_Surface *surface);
 static void DUMMY_FreeHWSurface(_THIS, SDL_Surface *surface);
+static int DUMMY_InitHWSurfaces(_THIS, Uint8 *base, int size, int screensize);
+static void DUMMY_FreeHWSurfaces(_THIS);
+static int DUMMY_CheckHWBlit(_THIS, SDL_Surface *src, SDL_Surface *dst);
+static int DUMMY_FillHWRect(_THIS, SDL_Surface *dst, SDL_Rect *rect, Uint32 color);
+static int DUMMY_SetHWColorKey(_THIS, SDL_Surface *surface, Uint32 key);
+static int DUMMY_SetHWAlpha(_THIS, SDL_Surface *surface, Uint8 value);
 
 /* etc. */
 static void DUMMY_UpdateRects(_THIS, int numrects, SDL_Rect *rects);
@@ -111,10 +139,10 @@ static SDL_VideoDevice *DUMMY_CreateDevice(int devindex)
 	device->UpdateRects = DUMMY_UpdateRects;
 	device->VideoQuit = DUMMY_VideoQuit;
 	device->AllocHWSurface = DUMMY_AllocHWSurface;
-	device->CheckHWBlit = NULL;
-	device->FillHWRect = NULL;
-	device->SetHWColorKey = NULL;
-	device->SetHWAlpha = NULL;
+	device->CheckHWBlit = DUMMY_CheckHWBlit;
+	device->FillHWRect = DUMMY_FillHWRect;
+	device->SetHWColorKey = DUMMY_SetHWColorKey;
+	device->SetHWAlpha = DUMMY_SetHWAlpha;
 	device->LockHWSurface = DUMMY_LockHWSurface;
 	device->UnlockHWSurface = DUMMY_UnlockHWSurface;
 	device->FlipHWSurface = NULL;
@@ -127,6 +155,10 @@ static SDL_VideoDevice *DUMMY_CreateDevice(int devindex)
 	device->InitOSKeymap = DUMMY_InitOSKeymap;
 	device->PumpEvents = DUMMY_PumpEvents;
 
+	/* There's no window system to upset by updating from a thread */
+	device->threaded_update = 1;
+	device->handles_frame_callback = 1;
+
 	device->free = DUMMY_DeleteDevice;
 
 	return device;
@@ -138,70 +170,472 @@ VideoBootStrap DUMMY_bootstrap = {
 };
 
 
+/* Parse the display depth, using the usual masks for it */
+static int DUMMY_ParseFormat(_THIS, const char *spec)
+{
+	this->hidden->bpp = SDL_atoi(spec);
+	switch (this->hidden->bpp) {
+	    case 8:
+		break;
+	    case 15:
+		this->hidden->Rmask = 0x7C00;
+		this->hidden->Gmask = 0x03E0;
+		this->hidden->Bmask = 0x001F;
+		break;
+	    case 16:
+		this->hidden->Rmask = 0xF800;
+		this->hidden->Gmask = 0x07E0;
+		this->hidden->Bmask = 0x001F;
+		break;
+	    case 24:
+	    case 32:
+		this->hidden->Rmask = 0x00FF0000;
+		this->hidden->Gmask = 0x0000FF00;
+		this->hidden->Bmask = 0x000000FF;
+		break;
+	    default:
+		SDL_SetError("Unsupported dummy display depth: %s", spec);
+		this->hidden->bpp = 0;
+		return(-1);
+	}
+	return(0);
+}
+
+/* Parse a list of modes like "1024x768,800x600", largest first */
+static int DUMMY_ParseModes(_THIS, const char *spec)
+{
+	const char *p;
+	int i, j, n, w, h;
+	SDL_Rect *mode;
+
+	n = 1;
+	for ( p = spec; *p; ++p ) {
+		if ( *p == ',' ) {
+			++n;
+		}
+	}
+	this->hidden->modes = (SDL_Rect **)SDL_malloc((n+1)*sizeof(SDL_Rect *));
+	if ( ! this->hidden->modes ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+
+	n = 0;
+	p = spec;
+	while ( *p ) {
+		w = SDL_atoi(p);
+		while ( *p && (*p != 'x') && (*p != ',') ) {
+			++p;
+		}
+		h = (*p == 'x') ? SDL_atoi(++p) : 0;
+		while ( *p && (*p != ',') ) {
+			++p;
+		}
+		if ( *p == ',' ) {
+			++p;
+		}
+		if ( (w <= 0) || (h <= 0) || (w > 0xFFFF) || (h > 0xFFFF) ) {
+			continue;
+		}
+		mode = (SDL_Rect *)SDL_malloc(sizeof(*mode));
+		if ( ! mode ) {
+			this->hidden->modes[n] = NULL;
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		mode->x = 0;
+		mode->y = 0;
+		mode->w = w;
+		mode->h = h;
+
+		/* Keep the list sorted, largest mode first */
+		for ( i = 0; i < n; ++i ) {
+			if ( (w > this->hidden->modes[i]->w) ||
+			     ((w == this->hidden->modes[i]->w) &&
+			      (h > this->hidden->modes[i]->h)) ) {
+				break;
+			}
+		}
+		for ( j = n; j > i; --j ) {
+			this->hidden->modes[j] = this->hidden->modes[j-1];
+		}
+		this->hidden->modes[i] = mode;
+		++n;
+	}
+	this->hidden->modes[n] = NULL;
+	if ( n == 0 ) {
+		SDL_free(this->hidden->modes);
+		this->hidden->modes = NULL;
+		SDL_SetError("No valid dummy video modes in: %s", spec);
+		return(-1);
+	}
+	return(0);
+}
+
 int DUMMY_VideoInit(_THIS, SDL_PixelFormat *vformat)
 {
+	const char *envr;
+
 	/*
 	fprintf(stderr, "WARNING: You are using the SDL dummy video driver!\n");
 	*/
 
+	/* See what the tester asked for */
+	envr = SDL_getenv("SDL_VIDEO_DUMMY_CAPTURE");
+	if ( envr && *envr ) {
+		this->hidden->capture_dir = SDL_strdup(envr);
+		if ( ! this->hidden->capture_dir ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+	}
+	envr = SDL_getenv("SDL_VIDEO_DUMMY_CAPTURE_FORMAT");
+	if ( envr && (SDL_strcasecmp(envr, "raw") == 0) ) {
+		this->hidden->capture_raw = 1;
+	}
+	envr = SDL_getenv("SDL_VIDEO_DUMMY_REFRESH");
+	if ( envr && (SDL_atoi(envr) > 0) ) {
+		this->hidden->refresh = SDL_atoi(envr);
+	}
+	envr = SDL_getenv("SDL_VIDEO_DUMMY_STATS");
+	if ( envr && SDL_atoi(envr) ) {
+		this->hidden->print_stats = 1;
+	}
+	this->hidden->start_ticks = SDL_GetTicks();
+	this->hidden->vblank = this->hidden->start_ticks;
+
 	/* Determine the screen depth (use default 8-bit depth) */
 	/* we change this during the SDL_SetVideoMode implementation... */
 	vformat->BitsPerPixel = 8;
 	vformat->BytesPerPixel = 1;
 
+	/* ...unless the display is meant to have a depth of its own */
+	envr = SDL_getenv("SDL_VIDEO_DUMMY_FORMAT");
+	if ( envr && *envr ) {
+		if ( DUMMY_ParseFormat(this, envr) < 0 ) {
+			return(-1);
+		}
+		vformat->BitsPerPixel = this->hidden->bpp;
+		vformat->BytesPerPixel = (this->hidden->bpp + 7) / 8;
+		vformat->Rmask = this->hidden->Rmask;
+		vformat->Gmask = this->hidden->Gmask;
+		vformat->Bmask = this->hidden->Bmask;
+	}
+	envr = SDL_getenv("SDL_VIDEO_DUMMY_MODES");
+	if ( envr && *envr ) {
+		if ( DUMMY_ParseModes(this, envr) < 0 ) {
+			return(-1);
+		}
+	}
+
+	/* Set up the emulated video memory and acceleration */
+	envr = SDL_getenv("SDL_VIDEO_DUMMY_VIDMEM");
+	if ( envr && (SDL_atoi(envr) > 0) ) {
+		this->hidden->vidmem_size = SDL_atoi(envr) * 1024;
+		this->hidden->vidmem = (Uint8 *)SDL_malloc(this->hidden->vidmem_size);
+		if ( ! this->hidden->vidmem ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		SDL_memset(this->hidden->vidmem, 0, this->hidden->vidmem_size);
+		envr = SDL_getenv("SDL_VIDEO_DUMMY_ACCEL");
+		if ( ! envr ) {
+			envr = "blit,colorkey,alpha,fill";
+		}
+		this->info.hw_available = 1;
+		this->info.video_mem = this->hidden->vidmem_size / 1024;
+		if ( SDL_strstr(envr, "blit") ) {
+			this->info.blit_hw = 1;
+			if ( SDL_strstr(envr, "colorkey") ) {
+				this->info.blit_hw_CC = 1;
+			}
+			if ( SDL_strstr(envr, "alpha") ) {
+				this->info.blit_hw_A = 1;
+			}
+		}
+		if ( SDL_strstr(envr, "fill") ) {
+			this->info.blit_fill = 1;
+		}
+	}
+
 	/* We're done! */
 	return(0);
 }
 
 SDL_Rect **DUMMY_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flags)
 {
+	if ( this->hidden->bpp &&
+	     (format->BitsPerPixel != this->hidden->bpp) ) {
+		return((SDL_Rect **)0);
+	}
+	if ( this->hidden->modes ) {
+		return(this->hidden->modes);
+	}
    	 return (SDL_Rect **) -1;
 }
 
 SDL_Surface *DUMMY_SetVideoMode(_THIS, SDL_Surface *current,
 				int width, int height, int bpp, Uint32 flags)
 {
+	int pitch, size;
+	Uint8 *pixels;
+
+	/* Anything else would be emulated with a shadow surface */
+	if ( this->hidden->bpp ) {
+		bpp = this->hidden->bpp;
+	}
+
+	/* Hardware surfaces from the last mode are gone with it */
+	DUMMY_FreeHWSurfaces(this);
 	if ( this->hidden->buffer ) {
 		SDL_free( this->hidden->buffer );
+		this->hidden->buffer = NULL;
 	}
 
-	this->hidden->buffer = SDL_malloc(width * height * (bpp / 8));
-	if ( ! this->hidden->buffer ) {
-		SDL_SetError("Couldn't allocate buffer for requested mode");
-		return(NULL);
+	pitch = width * ((bpp + 7) / 8);
+	size = pitch * height;
+	if ( (flags & SDL_HWSURFACE) && (size <= this->hidden->vidmem_size) ) {
+		/* The screen goes at the start of video memory */
+		pixels = this->hidden->vidmem;
+	} else {
+		this->hidden->buffer = SDL_malloc(size);
+		if ( ! this->hidden->buffer ) {
+			SDL_SetError("Couldn't allocate buffer for requested mode");
+			return(NULL);
+		}
+		pixels = (Uint8 *)this->hidden->buffer;
+		size = 0;
 	}
 
 /* 	printf("Setting mode %dx%d\n", width, height); */
 
-	SDL_memset(this->hidden->buffer, 0, width * height * (bpp / 8));
+	SDL_memset(pixels, 0, pitch * height);
 
 	/* Allocate the new pixel format for the screen */
-	if ( ! SDL_ReallocFormat(current, bpp, 0, 0, 0, 0) ) {
-		SDL_free(this->hidden->buffer);
-		this->hidden->buffer = NULL;
+	if ( ! SDL_ReallocFormat(current, bpp, this->hidden->Rmask,
+	                         this->hidden->Gmask, this->hidden->Bmask, 0) ) {
+		if ( this->hidden->buffer ) {
+			SDL_free(this->hidden->buffer);
+			this->hidden->buffer = NULL;
+		}
 		SDL_SetError("Couldn't allocate new pixel format for requested mode");
 		return(NULL);
 	}
 
 	/* Set up the new mode framebuffer */
 	current->flags = flags & SDL_FULLSCREEN;
+	if ( size ) {
+		current->flags |= SDL_HWSURFACE;
+	}
 	this->hidden->w = current->w = width;
 	this->hidden->h = current->h = height;
-	current->pitch = current->w * (bpp / 8);
-	current->pixels = this->hidden->buffer;
+	current->pitch = pitch;
+	current->pixels = pixels;
+
+	/* The rest of video memory is for other hardware surfaces */
+	if ( this->hidden->vidmem &&
+	     DUMMY_InitHWSurfaces(this, this->hidden->vidmem,
+	                          this->hidden->vidmem_size, size) < 0 ) {
+		return(NULL);
+	}
 
 	/* We're done */
 	return(current);
 }
 
-/* We don't actually allow hardware surfaces other than the main one */
+/* Hardware surfaces are carved out of the emulated video memory, the same
+   way the fbcon driver does with the real thing */
+static int DUMMY_InitHWSurfaces(_THIS, Uint8 *base, int size, int screensize)
+{
+	vidmem_bucket *bucket;
+
+	/* The first bucket is the screen, which may not be in video memory */
+	surfaces.prev = NULL;
+	surfaces.used = 1;
+	surfaces.base = base;
+	surfaces.size = screensize;
+	surfaces.next = NULL;
+	surfaces_memleft = size - screensize;
+
+	if ( surfaces_memleft > 0 ) {
+		bucket = (vidmem_bucket *)SDL_malloc(sizeof(*bucket));
+		if ( bucket == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		bucket->prev = &surfaces;
+		bucket->used = 0;
+		bucket->base = base + screensize;
+		bucket->size = surfaces_memleft;
+		bucket->next = NULL;
+		surfaces.next = bucket;
+	}
+	return(0);
+}
+static void DUMMY_FreeHWSurfaces(_THIS)
+{
+	vidmem_bucket *bucket, *freeable;
+
+	bucket = surfaces.next;
+	while ( bucket ) {
+		freeable = bucket;
+		bucket = bucket->next;
+		SDL_free(freeable);
+	}
+	surfaces.next = NULL;
+	surfaces_memleft = 0;
+}
+
 static int DUMMY_AllocHWSurface(_THIS, SDL_Surface *surface)
 {
-	return(-1);
+	vidmem_bucket *bucket;
+	int size;
+	int extra;
+
+	if ( ! this->hidden->vidmem ) {
+		SDL_SetError("No video memory, set SDL_VIDEO_DUMMY_VIDMEM");
+		return(-1);
+	}
+
+	/* Keep the buckets aligned for the blitters */
+	size = (surface->h * surface->pitch + 15) & ~15;
+
+	/* Quick check for available mem */
+	if ( size > surfaces_memleft ) {
+		SDL_SetError("Not enough video memory");
+		return(-1);
+	}
+
+	/* Search for an empty bucket big enough */
+	for ( bucket=&surfaces; bucket; bucket=bucket->next ) {
+		if ( ! bucket->used && (size <= bucket->size) ) {
+			break;
+		}
+	}
+	if ( bucket == NULL ) {
+		SDL_SetError("Video memory too fragmented");
+		return(-1);
+	}
+
+	/* Create a new bucket for left-over memory */
+	extra = (bucket->size - size);
+	if ( extra ) {
+		vidmem_bucket *newbucket;
+
+		newbucket = (vidmem_bucket *)SDL_malloc(sizeof(*newbucket));
+		if ( newbucket == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		newbucket->prev = bucket;
+		newbucket->used = 0;
+		newbucket->base = bucket->base+size;
+		newbucket->size = extra;
+		newbucket->next = bucket->next;
+		if ( bucket->next ) {
+			bucket->next->prev = newbucket;
+		}
+		bucket->next = newbucket;
+	}
+
+	/* Set the current bucket values and return it! */
+	bucket->used = 1;
+	bucket->size = size;
+	surfaces_memleft -= size;
+	surface->flags |= SDL_HWSURFACE;
+	surface->pixels = bucket->base;
+	surface->hwdata = (struct private_hwdata *)bucket;
+	return(0);
 }
 static void DUMMY_FreeHWSurface(_THIS, SDL_Surface *surface)
 {
-	return;
+	vidmem_bucket *bucket, *freeable;
+
+	/* Look for the bucket in the current list */
+	for ( bucket=&surfaces; bucket; bucket=bucket->next ) {
+		if ( bucket == (vidmem_bucket *)surface->hwdata ) {
+			break;
+		}
+	}
+	if ( bucket && bucket->used ) {
+		/* Add the memory back to the total */
+		surfaces_memleft += bucket->size;
+
+		/* Can we merge the space with surrounding buckets? */
+		bucket->used = 0;
+		if ( bucket->next && ! bucket->next->used ) {
+			freeable = bucket->next;
+			bucket->size += bucket->next->size;
+			bucket->next = bucket->next->next;
+			if ( bucket->next ) {
+				bucket->next->prev = bucket;
+			}
+			SDL_free(freeable);
+		}
+		if ( bucket->prev && ! bucket->prev->used ) {
+			freeable = bucket;
+			bucket->prev->size += bucket->size;
+			bucket->prev->next = bucket->next;
+			if ( bucket->next ) {
+				bucket->next->prev = bucket->prev;
+			}
+			SDL_free(freeable);
+		}
+	}
+	surface->pixels = NULL;
+	surface->hwdata = NULL;
+}
+
+/* The "accelerated" blits and fills are done by the software blitters, so
+   that programs take the same paths as they would on real hardware */
+static int DUMMY_HWAccelBlit(SDL_Surface *src, SDL_Rect *srcrect,
+                             SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	SDL_VideoDevice *this = current_video;
+	SDL_Rect rect;
+
+	SDL_Rect srect;
+
+	/* The software blit adds the screen offset itself */
+	if ( src == this->screen ) {
+		srect = *srcrect;
+		srect.x -= this->offset_x;
+		srect.y -= this->offset_y;
+		srcrect = &srect;
+	}
+	if ( dst == this->screen ) {
+		rect = *dstrect;
+		rect.x -= this->offset_x;
+		rect.y -= this->offset_y;
+		dstrect = &rect;
+	}
+	return(src->map->sw_blit(src, srcrect, dst, dstrect));
+}
+
+static int DUMMY_CheckHWBlit(_THIS, SDL_Surface *src, SDL_Surface *dst)
+{
+	/* SDL_CalculateBlit() only asks about blits we said we can do */
+	src->flags |= SDL_HWACCEL;
+	src->map->hw_blit = DUMMY_HWAccelBlit;
+	return(1);
+}
+
+static int DUMMY_FillHWRect(_THIS, SDL_Surface *dst, SDL_Rect *rect, Uint32 color)
+{
+	/* The rectangle already includes the screen offset, and the surface
+	   is unlocked, so the pixels are at the start of the frame */
+	SDL_FillRectSoftware(dst, rect, color);
+	return(0);
+}
+
+static int DUMMY_SetHWColorKey(_THIS, SDL_Surface *surface, Uint32 key)
+{
+	return(0);
+}
+
+static int DUMMY_SetHWAlpha(_THIS, SDL_Surface *surface, Uint8 value)
+{
+	return(0);
 }
 
 /* We need to wait for vertical retrace on page flipped displays */
@@ -215,9 +649,90 @@ static void DUMMY_UnlockHWSurface(_THIS, SDL_Surface *surface)
 	return;
 }
 
+/* Move on to the next virtual retrace, keeping the fractions of a
+   millisecond so the rate doesn't drift */
+static void DUMMY_NextVBlank(_THIS)
+{
+	this->hidden->vblank += 1000 / this->hidden->refresh;
+	this->hidden->vblank_frac += 1000 % this->hidden->refresh;
+	if ( this->hidden->vblank_frac >= this->hidden->refresh ) {
+		this->hidden->vblank_frac -= this->hidden->refresh;
+		++this->hidden->vblank;
+	}
+}
+
+static void DUMMY_WaitVBlank(_THIS)
+{
+	Uint32 now;
+
+	/* Skip the retraces we've missed */
+	now = SDL_GetTicks();
+	while ( (Sint32)(now - this->hidden->vblank) > 0 ) {
+		DUMMY_NextVBlank(this);
+	}
+	if ( this->hidden->vblank != now ) {
+		SDL_Delay(this->hidden->vblank - now);
+	}
+
+	/* Only one update per retrace */
+	DUMMY_NextVBlank(this);
+}
+
+/* Save the whole frame as frameNNNNNN.bmp, or .raw with the bare pixels
+   in the display format, in the capture directory */
+static void DUMMY_CaptureFrame(_THIS)
+{
+	SDL_Surface *screen = this->screen;
+	char file[1024];
+	SDL_RWops *dst;
+	Uint8 *row;
+	int y;
+
+	SDL_snprintf(file, sizeof(file), "%s/frame%06u.%s",
+	             this->hidden->capture_dir, (unsigned)this->hidden->frames,
+	             this->hidden->capture_raw ? "raw" : "bmp");
+	dst = SDL_RWFromFile(file, "wb");
+	if ( ! dst ) {
+		return;
+	}
+	/* Reading back the frame isn't drawing on it */
+	SDL_HoldDamage(screen);
+	if ( this->hidden->capture_raw ) {
+		row = (Uint8 *)screen->pixels;
+		for ( y = 0; y < screen->h; ++y ) {
+			SDL_RWwrite(dst, row,
+			            screen->w * screen->format->BytesPerPixel, 1);
+			row += screen->pitch;
+		}
+		SDL_RWclose(dst);
+	} else {
+		SDL_SaveBMP_RW(screen, dst, 1);
+	}
+	SDL_ReleaseDamage(screen);
+}
+
 static void DUMMY_UpdateRects(_THIS, int numrects, SDL_Rect *rects)
 {
-	/* do nothing. */
+	int i;
+
+	if ( this->hidden->refresh ) {
+		DUMMY_WaitVBlank(this);
+	}
+
+	/* There's nothing to see until a video mode is set */
+	if ( this->hidden->capture_dir && this->hidden->w ) {
+		DUMMY_CaptureFrame(this);
+	}
+
+	++this->hidden->frames;
+	this->hidden->rects += numrects;
+	for ( i = 0; i < numrects; ++i ) {
+		this->hidden->pixels += (Uint32)rects[i].w * rects[i].h;
+	}
+	if ( this->frame_callback ) {
+		this->frame_callback(this->frame_callback_data, this->screen,
+		                     numrects, rects);
+	}
 }
 
 int DUMMY_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
@@ -231,9 +746,40 @@ int DUMMY_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 */
 void DUMMY_VideoQuit(_THIS)
 {
-	if (this->screen->pixels != NULL)
-	{
-		SDL_free(this->screen->pixels);
-		this->screen->pixels = NULL;
+	if ( this->hidden->print_stats ) {
+		Uint32 ms = SDL_GetTicks() - this->hidden->start_ticks;
+
+		fprintf(stderr, "SDL dummy video: %u frames, %u rects, %u pixels in %u ms",
+		        (unsigned)this->hidden->frames,
+		        (unsigned)this->hidden->rects,
+		        (unsigned)this->hidden->pixels, (unsigned)ms);
+		if ( ms ) {
+			fprintf(stderr, " (%.1f fps)",
+			        this->hidden->frames * 1000.0 / ms);
+		}
+		fprintf(stderr, "\n");
+	}
+	if ( this->hidden->capture_dir ) {
+		SDL_free(this->hidden->capture_dir);
+		this->hidden->capture_dir = NULL;
+	}
+	DUMMY_FreeHWSurfaces(this);
+	if ( this->hidden->vidmem ) {
+		SDL_free(this->hidden->vidmem);
+		this->hidden->vidmem = NULL;
+	}
+	if ( this->hidden->buffer ) {
+		SDL_free(this->hidden->buffer);
+		this->hidden->buffer = NULL;
+	}
+	if ( this->hidden->modes ) {
+		int i;
+
+		for ( i = 0; this->hidden->modes[i]; ++i ) {
+			SDL_free(this->hidden->modes[i]);
+		}
+		SDL_free(this->hidden->modes);
+		this->hidden->modes = NULL;
 	}
+	this->screen->pixels = NULL;
 }
@@ -30,11 +30,47 @@
 #define _THIS	SDL_VideoDevice *this
 
 
+/* This is the structure we use to keep track of video memory */
+typedef struct vidmem_bucket {
+	struct vidmem_bucket *prev;
+	int used;
+	Uint8 *base;
+	unsigned int size;
+	struct vidmem_bucket *next;
+} vidmem_bucket;
+
 /* Private display data */
 
 struct SDL_PrivateVideoData {
     int w, h;
     void *buffer;
+
+    /* Display format and modes, any if not set */
+    int bpp;
+    Uint32 Rmask, Gmask, Bmask;
+    SDL_Rect **modes;
+
+    /* Emulated video memory, see DUMMY_AllocHWSurface() */
+    Uint8 *vidmem;
+    int vidmem_size;
+    vidmem_bucket surfaces;
+    int surfaces_memleft;
+
+    /* Frame capture, see DUMMY_CaptureFrame() */
+    char *capture_dir;
+    int capture_raw;
+
+    /* Virtual refresh rate, in Hz, and the time of the next retrace */
+    int refresh;
+    Uint32 vblank;
+    int vblank_frac;
+
+    /* Frame counters */
+    int print_stats;
+    Uint32 start_ticks;
+    Uint32 frames;
+    Uint32 rects;
+    Uint32 pixels;
 };
 
 #endif /* _SDL_nullvideo_h */
@@ -33,6 +33,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <fcntl.h>
 
 #include "SDL_timer.h"
 #include "SDL_syswm.h"
@@ -951,6 +952,94 @@ int X11_Pending(Display *display)
 	return(0);
 }
 
+void X11_InitWaitEvents(_THIS)
+{
+	int i;
+
+	if ( pipe(wake_pipe) < 0 ) {
+		wake_pipe[0] = -1;
+		wake_pipe[1] = -1;
+		return;
+	}
+	for ( i = 0; i < 2; ++i ) {
+		fcntl(wake_pipe[i], F_SETFL,
+		      fcntl(wake_pipe[i], F_GETFL) | O_NONBLOCK);
+		fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+	}
+}
+
+void X11_QuitWaitEvents(_THIS)
+{
+	int i;
+
+	for ( i = 0; i < 2; ++i ) {
+		if ( wake_pipe[i] >= 0 ) {
+			close(wake_pipe[i]);
+			wake_pipe[i] = -1;
+		}
+	}
+}
+
+/* Sleep until the X server has something for us, or we're woken up */
+int X11_WaitEvents(_THIS, int timeout)
+{
+	struct timeval tv;
+	fd_set fdset;
+	int x11_fd, maxfd;
+	char buf[64];
+
+	if ( (SDL_Display == NULL) || (wake_pipe[0] < 0) ) {
+		return(-1);
+	}
+
+	/* Don't sleep through a mode switch or a screensaver reset */
+	if ( switch_waiting ) {
+		int left = (int)(switch_time - SDL_GetTicks());
+		if ( left < 0 ) {
+			left = 0;
+		}
+		if ( (timeout < 0) || (left < timeout) ) {
+			timeout = left;
+		}
+	}
+	if ( !allow_screensaver && ((timeout < 0) || (timeout > 5000)) ) {
+		timeout = 5000;
+	}
+
+	XFlush(SDL_Display);
+	if ( XEventsQueued(SDL_Display, QueuedAlready) ) {
+		return(0);
+	}
+	x11_fd = ConnectionNumber(SDL_Display);
+	FD_ZERO(&fdset);
+	FD_SET(x11_fd, &fdset);
+	FD_SET(wake_pipe[0], &fdset);
+	maxfd = (x11_fd > wake_pipe[0]) ? x11_fd : wake_pipe[0];
+	if ( timeout < 0 ) {
+		select(maxfd+1, &fdset, NULL, NULL, NULL);
+	} else {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		select(maxfd+1, &fdset, NULL, NULL, &tv);
+	}
+
+	/* Empty the wakeup pipe */
+	while ( read(wake_pipe[0], buf, sizeof(buf)) > 0 ) {
+		;
+	}
+	return(0);
+}
+
+void X11_WakeEvents(_THIS)
+{
+	if ( wake_pipe[1] >= 0 ) {
+		/* If the pipe is full, a wakeup is already pending */
+		if ( write(wake_pipe[1], "", 1) < 0 ) {
+			return;
+		}
+	}
+}
+
 void X11_PumpEvents(_THIS)
 {
 	int pending;
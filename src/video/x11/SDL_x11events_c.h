@@ -26,6 +26,10 @@
 /* Functions to be exported */
 extern void X11_InitOSKeymap(_THIS);
 extern void X11_PumpEvents(_THIS);
+extern void X11_InitWaitEvents(_THIS);
+extern void X11_QuitWaitEvents(_THIS);
+extern int X11_WaitEvents(_THIS, int timeout);
+extern void X11_WakeEvents(_THIS);
 extern void X11_SetKeyboardState(Display *display, const char *key_vec);
 
 /* Variables to be exported */
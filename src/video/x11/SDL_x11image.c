@@ -25,6 +25,7 @@
 #include <unistd.h>
 
 #include "SDL_endian.h"
+#include "SDL_cpuinfo.h"
 #include "../../events/SDL_events_c.h"
 #include "SDL_x11image_c.h"
 
@@ -145,39 +146,6 @@ void X11_DestroyImage(_THIS, SDL_Surface *screen)
 	}
 }
 
-/* Determine the number of CPUs in the system */
-static int num_CPU(void)
-{
-       static int num_cpus = 0;
-
-       if(!num_cpus) {
-#if defined(__LINUX__)
-           char line[BUFSIZ];
-           FILE *pstat = fopen("/proc/stat", "r");
-           if ( pstat ) {
-               while ( fgets(line, sizeof(line), pstat) ) {
-                   if (SDL_memcmp(line, "cpu", 3) == 0 && line[3] != ' ') {
-                       ++num_cpus;
-                   }
-               }
-               fclose(pstat);
-           }
-#elif defined(__IRIX__)
-	   num_cpus = sysconf(_SC_NPROC_ONLN);
-#elif defined(_SC_NPROCESSORS_ONLN)
-	   /* number of processors online (SVR4.0MP compliant machines) */
-           num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
-#elif defined(_SC_NPROCESSORS_CONF)
-	   /* number of processors configured (SVR4.0MP compliant machines) */
-           num_cpus = sysconf(_SC_NPROCESSORS_CONF);
-#endif
-           if ( num_cpus <= 0 ) {
-               num_cpus = 1;
-           }
-       }
-       return num_cpus;
-}
-
 int X11_ResizeImage(_THIS, SDL_Surface *screen, Uint32 flags)
 {
 	int retval;
@@ -194,7 +162,7 @@ int X11_ResizeImage(_THIS, SDL_Surface *screen, Uint32 flags)
 			   X server and the application.
 			   Note: Is this still true with XFree86 4.0?
 			*/
-			if ( num_CPU() > 1 ) {
+			if ( SDL_GetCPUCount() > 1 ) {
 				screen->flags |= SDL_ASYNCBLIT;
 			}
 		}
@@ -121,6 +121,13 @@ static SDL_VideoDevice *X11_CreateDevice(int devindex)
 		SDL_memset(device->hidden, 0, (sizeof *device->hidden));
 		SDL_memset(device->gl_data, 0, (sizeof *device->gl_data));
 
+		/* There's no wakeup pipe until X11_VideoInit() makes one */
+		{
+			_THIS = device;
+			wake_pipe[0] = -1;
+			wake_pipe[1] = -1;
+		}
+
 #if SDL_VIDEO_OPENGL_GLX
 		device->gl_data->swap_interval = -1;
 #endif
@@ -172,6 +179,8 @@ static SDL_VideoDevice *X11_CreateDevice(int devindex)
 		device->CheckMouseMode = X11_CheckMouseMode;
 		device->InitOSKeymap = X11_InitOSKeymap;
 		device->PumpEvents = X11_PumpEvents;
+		device->WaitEvents = X11_WaitEvents;
+		device->WakeEvents = X11_WakeEvents;
 
 		device->free = X11_DeleteDevice;
 	}
@@ -639,6 +648,9 @@ static int X11_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	/* use default screen (from $DISPLAY) */
 	SDL_Screen = DefaultScreen(SDL_Display);
 
+	/* Let event waits be interrupted */
+	X11_InitWaitEvents(this);
+
 #ifndef NO_SHARED_MEMORY
 	/* Check for MIT shared memory extension */
 	use_mitshm = 0;
@@ -1560,6 +1572,7 @@ void X11_VideoQuit(_THIS)
 		/* Close the X11 display connection */
 		XCloseDisplay(SDL_Display);
 		SDL_Display = NULL;
+		X11_QuitWaitEvents(this);
 
 		/* Reset the X11 error handlers */
 		if ( XIO_handler ) {
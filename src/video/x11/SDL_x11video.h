@@ -154,6 +154,9 @@ struct SDL_PrivateVideoData {
 
     /* Screensaver settings */
     int allow_screensaver;
+
+    /* Written to wake up X11_WaitEvents() */
+    int wake_pipe[2];
 };
 
 /* Old variable names */
@@ -205,6 +208,7 @@ struct SDL_PrivateVideoData {
 #define gamma_changed		(this->hidden->gamma_changed)
 #define SDL_iconcolors		(this->hidden->iconcolors)
 #define allow_screensaver	(this->hidden->allow_screensaver)
+#define wake_pipe		(this->hidden->wake_pipe)
 
 /* Some versions of XFree86 have bugs - detect if this is one of them */
 #define BUGGY_XFREE86(condition, buggy_version) \
@@ -0,0 +1,554 @@
+
+/* Benchmark of the software blitters, for spotting performance regressions.
+
+   Every combination of source format, destination format and blit mode
+   (plain copy, colorkey, surface alpha, per-pixel alpha, with and without
+   RLE acceleration) is timed at a few sizes.  The results can be saved as
+   JSON, and compared against a previous run to find the combinations that
+   got slower.  This runs on the dummy video driver unless SDL_VIDEODRIVER
+   says otherwise, so it doesn't need a display.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#define DEFAULT_TIME	50		/* milliseconds per combination */
+#define DEFAULT_SIZES	"32x32,256x256,1024x768"
+#define MAX_SIZES	16
+#define MAX_BASELINE	8192
+
+/* The pixel formats to try, as sources and as destinations */
+static const struct {
+	const char *name;
+	int bpp;
+	Uint32 Rmask, Gmask, Bmask, Amask;
+} formats[] = {
+	{ "index8",   8, 0, 0, 0, 0 },
+	{ "rgb555",   15, 0x7C00, 0x03E0, 0x001F, 0 },
+	{ "rgb565",   16, 0xF800, 0x07E0, 0x001F, 0 },
+	{ "bgr565",   16, 0x001F, 0x07E0, 0xF800, 0 },
+	{ "rgb888",   24, 0xFF0000, 0x00FF00, 0x0000FF, 0 },
+	{ "xrgb8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0 },
+	{ "xbgr8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0 },
+	{ "argb8888", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 },
+	{ "abgr8888", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 },
+};
+#define NUM_FORMATS	(sizeof(formats)/sizeof(formats[0]))
+
+/* The blit modes, and whether they apply to sources with an alpha channel */
+enum { MODE_COPY, MODE_KEY, MODE_ALPHA, MODE_KEYALPHA, MODE_PIXELALPHA };
+static const struct {
+	const char *name;
+	int alpha_source;	/* 0 = no, 1 = yes, 2 = only */
+	int rle;		/* RLE acceleration makes a difference */
+} modes[] = {
+	{ "copy",       1, 0 },
+	{ "key",        0, 1 },
+	{ "alpha",      0, 0 },
+	{ "keyalpha",   0, 1 },
+	{ "pixelalpha", 2, 1 },
+};
+#define NUM_MODES	(sizeof(modes)/sizeof(modes[0]))
+
+typedef struct {
+	char src[32];
+	char dst[32];
+	char mode[32];
+	int rle;
+	int w, h;
+	double mpixels;
+} Result;
+
+static Result baseline[MAX_BASELINE];
+static int num_baseline = 0;
+
+/* Command line selections, NULL for all */
+static const char *src_list = NULL;
+static const char *dst_list = NULL;
+static const char *mode_list = NULL;
+static int rle_only = -1;
+static Uint32 time_ms = DEFAULT_TIME;
+static SDL_Rect sizes[MAX_SIZES];
+static int num_sizes = 0;
+
+
+/* A cycle counter, where there's an easy one */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define HAVE_CYCLES
+static Uint64 cycles(void)
+{
+	Uint32 lo, hi;
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return(((Uint64)hi << 32) | lo);
+}
+#endif
+
+static int in_list(const char *list, const char *name)
+{
+	size_t len = strlen(name);
+	const char *p;
+
+	if ( list == NULL ) {
+		return(1);
+	}
+	for ( p = list; (p = strstr(p, name)) != NULL; p += len ) {
+		if ( (p == list || p[-1] == ',') &&
+		     (p[len] == '\0' || p[len] == ',') ) {
+			return(1);
+		}
+	}
+	return(0);
+}
+
+static int parse_sizes(const char *spec)
+{
+	int w, h;
+
+	num_sizes = 0;
+	while ( *spec && num_sizes < MAX_SIZES ) {
+		if ( sscanf(spec, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0 ) {
+			fprintf(stderr, "Bad size list: %s\n", spec);
+			return(-1);
+		}
+		sizes[num_sizes].w = w;
+		sizes[num_sizes].h = h;
+		++num_sizes;
+		spec = strchr(spec, ',');
+		if ( !spec ) {
+			break;
+		}
+		++spec;
+	}
+	return(0);
+}
+
+/* Simple repeatable pseudo-random numbers */
+static Uint32 seed = 1;
+static Uint32 next_random(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return(seed >> 8);
+}
+
+static SDL_Surface *create_surface(int f, int w, int h)
+{
+	SDL_Surface *surface;
+
+	surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, formats[f].bpp,
+	                               formats[f].Rmask, formats[f].Gmask,
+	                               formats[f].Bmask, formats[f].Amask);
+	if ( surface && surface->format->palette ) {
+		SDL_Color colors[256];
+		int i;
+
+		/* A 3-3-2 palette */
+		for ( i = 0; i < 256; ++i ) {
+			colors[i].r = (i >> 5) * 255 / 7;
+			colors[i].g = ((i >> 2) & 7) * 255 / 7;
+			colors[i].b = (i & 3) * 255 / 3;
+		}
+		SDL_SetColors(surface, colors, 0, 256);
+	}
+	return(surface);
+}
+
+/* Fill a source with noise, with runs of transparent and opaque pixels
+   like a typical sprite has */
+static void fill_source(SDL_Surface *surface, Uint32 key)
+{
+	SDL_PixelFormat *fmt = surface->format;
+	int x, y, run, clear;
+	Uint8 r, g, b, a;
+	Uint32 pixel;
+
+	seed = 1;
+	SDL_LockSurface(surface);
+	for ( y = 0; y < surface->h; ++y ) {
+		Uint8 *row = (Uint8 *)surface->pixels + y * surface->pitch;
+		run = 0;
+		clear = 0;
+		for ( x = 0; x < surface->w; ++x ) {
+			if ( run == 0 ) {
+				run = 1 + next_random() % 32;
+				clear = (next_random() % 3 == 0);
+			}
+			--run;
+			r = next_random();
+			g = next_random();
+			b = next_random();
+			a = (next_random() % 4) ? 255 : next_random();
+			if ( clear ) {
+				a = 0;
+			}
+			pixel = SDL_MapRGBA(fmt, r, g, b, a);
+			if ( clear && !fmt->Amask ) {
+				pixel = key;
+			} else if ( pixel == key && !fmt->Amask ) {
+				pixel ^= 1;
+			}
+			switch ( fmt->BytesPerPixel ) {
+			    case 1:
+				row[x] = (Uint8)pixel;
+				break;
+			    case 2:
+				((Uint16 *)row)[x] = (Uint16)pixel;
+				break;
+			    case 3:
+				SDL_memcpy(row + x * 3, &pixel, 3);
+				break;
+			    case 4:
+				((Uint32 *)row)[x] = pixel;
+				break;
+			}
+		}
+	}
+	SDL_UnlockSurface(surface);
+}
+
+/* Time one combination, returns megapixels per second, or -1 if SDL
+   can't blit it */
+static double run_blit(SDL_Surface *src, SDL_Surface *dst,
+                       double *cycles_per_pixel)
+{
+	SDL_Rect rect;
+	Uint32 start, now;
+	Uint32 count, i;
+#ifdef HAVE_CYCLES
+	Uint64 cycle_start;
+#endif
+
+	/* The first blit sets up the mapping and any RLE encoding */
+	rect.x = 0;
+	rect.y = 0;
+	if ( SDL_BlitSurface(src, NULL, dst, &rect) < 0 ) {
+		return(-1.0);
+	}
+
+	count = 0;
+	start = SDL_GetTicks();
+#ifdef HAVE_CYCLES
+	cycle_start = cycles();
+#endif
+	do {
+		for ( i = 0; i < 16; ++i ) {
+			rect.x = 0;
+			rect.y = 0;
+			SDL_BlitSurface(src, NULL, dst, &rect);
+		}
+		count += 16;
+		now = SDL_GetTicks();
+	} while ( (now - start) < time_ms );
+
+#ifdef HAVE_CYCLES
+	*cycles_per_pixel = (double)(Sint64)(cycles() - cycle_start) /
+	                    ((double)count * src->w * src->h);
+#else
+	*cycles_per_pixel = -1.0;
+#endif
+	if ( now == start ) {
+		++now;
+	}
+	return((double)count * src->w * src->h / ((now - start) * 1000.0));
+}
+
+static int load_baseline(const char *file)
+{
+	FILE *fp;
+	char line[512];
+	Result *r;
+
+	fp = fopen(file, "r");
+	if ( !fp ) {
+		fprintf(stderr, "Couldn't open baseline %s\n", file);
+		return(-1);
+	}
+	while ( fgets(line, sizeof(line), fp) && num_baseline < MAX_BASELINE ) {
+		r = &baseline[num_baseline];
+		if ( sscanf(line, " {\"src\": \"%31[^\"]\", \"dst\": \"%31[^\"]\", "
+		                  "\"mode\": \"%31[^\"]\", \"rle\": %d, "
+		                  "\"w\": %d, \"h\": %d, \"mpixels_per_sec\": %lf",
+		            r->src, r->dst, r->mode, &r->rle,
+		            &r->w, &r->h, &r->mpixels) == 7 ) {
+			++num_baseline;
+		}
+	}
+	fclose(fp);
+	if ( num_baseline == 0 ) {
+		fprintf(stderr, "No results found in baseline %s\n", file);
+		return(-1);
+	}
+	return(0);
+}
+
+static const Result *find_baseline(const Result *result)
+{
+	int i;
+
+	for ( i = 0; i < num_baseline; ++i ) {
+		const Result *r = &baseline[i];
+		if ( strcmp(r->src, result->src) == 0 &&
+		     strcmp(r->dst, result->dst) == 0 &&
+		     strcmp(r->mode, result->mode) == 0 &&
+		     r->rle == result->rle &&
+		     r->w == result->w && r->h == result->h ) {
+			return(r);
+		}
+	}
+	return(NULL);
+}
+
+static void usage(const char *argv0)
+{
+	unsigned int i;
+
+	fprintf(stderr,
+"Usage: %s [options]\n"
+"  --src NAME[,NAME...]     source formats to test (default all)\n"
+"  --dst NAME[,NAME...]     destination formats to test (default all)\n"
+"  --mode NAME[,NAME...]    blit modes to test (default all)\n"
+"  --rle | --norle          only test with or without RLE acceleration\n"
+"  --sizes WxH[,WxH...]     blit sizes (default " DEFAULT_SIZES ")\n"
+"  --time MS                time spent on each combination (default %d)\n"
+"  --json FILE              save the results as JSON\n"
+"  --baseline FILE          compare with the JSON results of another run\n"
+"  --tolerance PERCENT      slowdown reported as a regression (default 10)\n",
+		argv0, DEFAULT_TIME);
+	fprintf(stderr, "Formats:");
+	for ( i = 0; i < NUM_FORMATS; ++i ) {
+		fprintf(stderr, " %s", formats[i].name);
+	}
+	fprintf(stderr, "\nModes:");
+	for ( i = 0; i < NUM_MODES; ++i ) {
+		fprintf(stderr, " %s", modes[i].name);
+	}
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *json_file = NULL;
+	const char *baseline_file = NULL;
+	double tolerance = 10.0;
+	FILE *json = NULL;
+	int first = 1;
+	int regressions = 0, compared = 0;
+	unsigned int s, d, m;
+	int i, rle, size;
+
+	parse_sizes(DEFAULT_SIZES);
+	for ( i = 1; i < argc; ++i ) {
+		if ( strcmp(argv[i], "--src") == 0 && argv[i+1] ) {
+			src_list = argv[++i];
+		} else if ( strcmp(argv[i], "--dst") == 0 && argv[i+1] ) {
+			dst_list = argv[++i];
+		} else if ( strcmp(argv[i], "--mode") == 0 && argv[i+1] ) {
+			mode_list = argv[++i];
+		} else if ( strcmp(argv[i], "--rle") == 0 ) {
+			rle_only = 1;
+		} else if ( strcmp(argv[i], "--norle") == 0 ) {
+			rle_only = 0;
+		} else if ( strcmp(argv[i], "--sizes") == 0 && argv[i+1] ) {
+			if ( parse_sizes(argv[++i]) < 0 ) {
+				return(1);
+			}
+		} else if ( strcmp(argv[i], "--time") == 0 && argv[i+1] ) {
+			time_ms = atoi(argv[++i]);
+			if ( time_ms == 0 ) {
+				time_ms = 1;
+			}
+		} else if ( strcmp(argv[i], "--json") == 0 && argv[i+1] ) {
+			json_file = argv[++i];
+		} else if ( strcmp(argv[i], "--baseline") == 0 && argv[i+1] ) {
+			baseline_file = argv[++i];
+		} else if ( strcmp(argv[i], "--tolerance") == 0 && argv[i+1] ) {
+			tolerance = atof(argv[++i]);
+		} else {
+			usage(argv[0]);
+			return(1);
+		}
+	}
+	if ( baseline_file && load_baseline(baseline_file) < 0 ) {
+		return(1);
+	}
+
+	/* No display needed */
+	if ( !getenv("SDL_VIDEODRIVER") ) {
+		putenv("SDL_VIDEODRIVER=dummy");
+	}
+	if ( SDL_Init(SDL_INIT_VIDEO) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+	atexit(SDL_Quit);
+	if ( !SDL_SetVideoMode(64, 64, 0, SDL_SWSURFACE) ) {
+		fprintf(stderr, "Couldn't set video mode: %s\n", SDL_GetError());
+		return(1);
+	}
+
+	if ( json_file ) {
+		const SDL_version *v = SDL_Linked_Version();
+
+		json = fopen(json_file, "w");
+		if ( !json ) {
+			fprintf(stderr, "Couldn't create %s\n", json_file);
+			return(1);
+		}
+		fprintf(json, "{\n");
+		fprintf(json, "  \"sdl_version\": \"%d.%d.%d\",\n",
+		        v->major, v->minor, v->patch);
+		fprintf(json, "  \"cpu\": {\"mmx\": %d, \"sse\": %d, \"sse2\": %d, "
+		              "\"altivec\": %d, \"neon\": %d},\n",
+		        SDL_HasMMX(), SDL_HasSSE(), SDL_HasSSE2(),
+		        SDL_HasAltiVec(), SDL_HasARMNEON());
+		fprintf(json, "  \"time_ms\": %u,\n", (unsigned)time_ms);
+		fprintf(json, "  \"results\": [\n");
+	}
+
+	printf("%-9s %-9s %-10s %-3s %9s %10s %9s",
+	       "src", "dst", "mode", "rle", "size", "Mpixels/s", "cyc/pixel");
+	if ( num_baseline ) {
+		printf(" %8s", "change");
+	}
+	printf("  blitter\n");
+
+	for ( s = 0; s < NUM_FORMATS; ++s )
+	for ( d = 0; d < NUM_FORMATS; ++d )
+	for ( m = 0; m < NUM_MODES; ++m )
+	for ( rle = 0; rle <= modes[m].rle; ++rle )
+	for ( size = 0; size < num_sizes; ++size ) {
+		int w = sizes[size].w, h = sizes[size].h;
+		int alpha_source = (formats[s].Amask != 0);
+		SDL_Surface *src, *dst;
+		double mpixels, cpp;
+		const char *kernel;
+		const Result *base;
+		Result result;
+		int slower;
+		Uint32 key;
+
+		if ( !in_list(src_list, formats[s].name) ||
+		     !in_list(dst_list, formats[d].name) ||
+		     !in_list(mode_list, modes[m].name) ||
+		     (rle_only >= 0 && rle != rle_only) ) {
+			continue;
+		}
+		if ( (alpha_source && !modes[m].alpha_source) ||
+		     (!alpha_source && modes[m].alpha_source == 2) ) {
+			continue;
+		}
+
+		src = create_surface(s, w, h);
+		dst = create_surface(d, w, h);
+		if ( !src || !dst ) {
+			fprintf(stderr, "Couldn't create surfaces: %s\n",
+			        SDL_GetError());
+			return(1);
+		}
+		key = SDL_MapRGB(src->format, 255, 0, 255);
+		fill_source(src, key);
+		SDL_FillRect(dst, NULL, SDL_MapRGB(dst->format, 32, 64, 96));
+
+		switch ( m ) {
+		    case MODE_COPY:
+			SDL_SetAlpha(src, 0, 0);
+			break;
+		    case MODE_KEY:
+			SDL_SetColorKey(src, SDL_SRCCOLORKEY |
+			                (rle ? SDL_RLEACCEL : 0), key);
+			break;
+		    case MODE_ALPHA:
+			SDL_SetAlpha(src, SDL_SRCALPHA, 128);
+			break;
+		    case MODE_KEYALPHA:
+			SDL_SetColorKey(src, SDL_SRCCOLORKEY |
+			                (rle ? SDL_RLEACCEL : 0), key);
+			SDL_SetAlpha(src, SDL_SRCALPHA |
+			             (rle ? SDL_RLEACCEL : 0), 128);
+			break;
+		    case MODE_PIXELALPHA:
+			SDL_SetAlpha(src, SDL_SRCALPHA |
+			             (rle ? SDL_RLEACCEL : 0), 255);
+			break;
+		}
+
+		mpixels = run_blit(src, dst, &cpp);
+		if ( mpixels < 0.0 ) {
+			/* Not timed, so it stays out of the results */
+			printf("%-9s %-9s %-10s %-3s %4dx%-4d  unsupported: %s\n",
+			       formats[s].name, formats[d].name, modes[m].name,
+			       rle ? "yes" : "no", w, h, SDL_GetError());
+			SDL_FreeSurface(src);
+			SDL_FreeSurface(dst);
+			continue;
+		}
+		if ( SDL_GetBlitInfo(src, dst, NULL, &kernel, NULL) < 0 ) {
+			kernel = "unknown";
+		}
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dst);
+
+		strcpy(result.src, formats[s].name);
+		strcpy(result.dst, formats[d].name);
+		strcpy(result.mode, modes[m].name);
+		result.rle = rle;
+		result.w = w;
+		result.h = h;
+		result.mpixels = mpixels;
+
+		printf("%-9s %-9s %-10s %-3s %4dx%-4d %10.2f",
+		       result.src, result.dst, result.mode, rle ? "yes" : "no",
+		       w, h, mpixels);
+		if ( cpp >= 0.0 ) {
+			printf(" %9.2f", cpp);
+		} else {
+			printf(" %9s", "-");
+		}
+		slower = 0;
+		base = num_baseline ? find_baseline(&result) : NULL;
+		if ( base && base->mpixels > 0.0 ) {
+			double change;
+
+			change = (mpixels - base->mpixels) * 100.0 / base->mpixels;
+			printf(" %+7.1f%%", change);
+			if ( change < -tolerance ) {
+				slower = 1;
+				++regressions;
+			}
+			++compared;
+		} else if ( num_baseline ) {
+			printf(" %8s", "");
+		}
+		printf("  %s%s\n", kernel, slower ? "  REGRESSION" : "");
+		fflush(stdout);
+
+		if ( json ) {
+			fprintf(json, "%s    {\"src\": \"%s\", \"dst\": \"%s\", "
+			              "\"mode\": \"%s\", \"rle\": %d, "
+			              "\"w\": %d, \"h\": %d, "
+			              "\"mpixels_per_sec\": %.2f, ",
+			        first ? "" : ",\n",
+			        result.src, result.dst, result.mode, rle,
+			        w, h, mpixels);
+			if ( cpp >= 0.0 ) {
+				fprintf(json, "\"cycles_per_pixel\": %.2f, ", cpp);
+			} else {
+				fprintf(json, "\"cycles_per_pixel\": null, ");
+			}
+			fprintf(json, "\"blitter\": \"%s\"}", kernel);
+			first = 0;
+		}
+	}
+
+	if ( json ) {
+		fprintf(json, "\n  ]\n}\n");
+		fclose(json);
+	}
+	if ( num_baseline ) {
+		printf("%d of %d combinations more than %.1f%% slower than the baseline\n",
+		       regressions, compared, tolerance);
+	}
+	return(regressions ? 2 : 0);
+}
@@ -27,13 +27,43 @@ static Uint32 SDLCALL callback(Uint32 interval, void *param)
 int main(int argc, char *argv[])
 {
 	int desired;
+	int i;
 	SDL_TimerID t1, t2, t3;
+	Uint64 start, now;
+	SDL_FrameLimiter *limiter;
+	SDL_FrameStats stats;
 
 	if ( SDL_Init(SDL_INIT_TIMER) < 0 ) {
 		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
 		return(1);
 	}
 
+	/* Check the high resolution counter against SDL_Delay() */
+	start = SDL_GetPerformanceCounter();
+	SDL_Delay(100);
+	now = SDL_GetPerformanceCounter();
+	printf("Performance counter: %.3f ms for a 100 ms delay (%.0f counts per second)\n",
+		(double)(now - start) * 1000.0 / SDL_GetPerformanceFrequency(),
+		(double)SDL_GetPerformanceFrequency());
+
+	/* Check the precise delay and the frame limiter */
+	start = SDL_GetPerformanceCounter();
+	SDL_DelayPrecise(2500);
+	now = SDL_GetPerformanceCounter();
+	printf("Precise delay: %.3f ms for a 2.5 ms delay\n",
+		(double)(now - start) * 1000.0 / SDL_GetPerformanceFrequency());
+	limiter = SDL_CreateFrameLimiter(60.0);
+	if ( limiter ) {
+		for ( i = 0; i < 60; ++i ) {
+			SDL_FrameLimiterWait(limiter);
+		}
+		SDL_GetFrameStats(limiter, &stats);
+		printf("Frame limiter: %d frames at 60 Hz, %d missed, %d us apart, jitter %d us (max %d us)\n",
+			stats.frames, stats.missed, stats.frame_avg,
+			stats.jitter_avg, stats.jitter_max);
+		SDL_FreeFrameLimiter(limiter);
+	}
+
 	/* Start the timer */
 	desired = 0;
 	if ( argv[1] ) {